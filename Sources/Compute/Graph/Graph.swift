@@ -64,6 +64,24 @@ extension Graph {
     public static func anyInputsChanged(excluding excludedAttributes: [AnyAttribute]) -> Bool {
         return __IAGGraphAnyInputsChanged(excludedAttributes, excludedAttributes.count)
     }
+
+    public static func invalidateValues(_ attributes: [AnyAttribute]) {
+        __IAGGraphInvalidateValues(attributes, attributes.count)
+    }
+
+    @discardableResult
+    public static func setValues<Value>(_ attributes: [Attribute<Value>], to values: [Value]) -> Int {
+        precondition(attributes.count == values.count, "attribute and value counts differ")
+        guard !attributes.isEmpty else {
+            return 0
+        }
+        let identifiers = attributes.map { $0.identifier }
+        let types = [Metadata](repeating: Metadata(Value.self), count: values.count)
+        return values.withUnsafeBufferPointer { buffer in
+            let valuePointers = (0..<buffer.count).map { UnsafeRawPointer(buffer.baseAddress! + $0) }
+            return Int(__IAGGraphSetValues(identifiers, valuePointers, types, identifiers.count))
+        }
+    }
 }
 
 @_silgen_name("IAGGraphSetUpdateCallback")
@@ -128,11 +146,11 @@ extension Graph {
 
 extension Graph {
     public static func startProfiling(_ graph: Graph?) {
-        fatalError("not implemented")
+        __IAGGraphStartProfiling(graph)
     }
 
     public static func stopProfiling(_ graph: Graph?) {
-        fatalError("not implemented")
+        __IAGGraphStopProfiling(graph)
     }
 
     public static func markProfile(name: UnsafePointer<Int8>) {
@@ -141,7 +159,14 @@ extension Graph {
     }
 
     public static func resetProfile() {
-        fatalError("not implemented")
+        __IAGGraphResetProfile(nil)
+    }
+
+    public var profileEntries: [IAGProfileEntry] {
+        let count = __IAGGraphCopyProfileData(self, nil, 0)
+        return [IAGProfileEntry](unsafeUninitializedCapacity: count) { buffer, initializedCount in
+            initializedCount = __IAGGraphCopyProfileData(self, buffer.baseAddress, count)
+        }
     }
 }
 
@@ -195,16 +220,33 @@ extension Graph {
     }
 }
 
+extension Graph {
+    public func archiveJSON(name: String?) {
+        Graph.archiveJSON(name: name?.cString(using: .utf8))
+    }
+
+    @discardableResult
+    public func exportJSON(to fileDescriptor: Int32, options: IAGGraphExportOptions = []) -> Bool {
+        __IAGGraphExportJSON(self, fileDescriptor, options)
+    }
+
+    @discardableResult
+    public func exportDot(to fileDescriptor: Int32, options: IAGGraphExportOptions = []) -> Bool {
+        __IAGGraphExportDot(self, fileDescriptor, options)
+    }
+
+    @discardableResult
+    public func writeSnapshot(to fileDescriptor: Int32) -> Bool {
+        __IAGGraphWriteSnapshot(self, fileDescriptor)
+    }
+}
+
 #if canImport(Darwin)
 extension Graph {
     public func print(includeValues: Bool) {
         Swift.print(graphvizDescription(includeValues: includeValues))
     }
 
-    public func archiveJSON(name: String?) {
-        Graph.archiveJSON(name: name?.cString(using: .utf8))
-    }
-
     public func graphvizDescription(includeValues: Bool) -> String {
         let options: NSDictionary = [
             DescriptionOption.format: "graph/dot",
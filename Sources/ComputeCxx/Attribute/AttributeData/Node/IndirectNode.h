@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "Attribute/AttributeData/Edge/OutputEdge.h"
 #include "Attribute/AttributeID/AttributeID.h"
 #include "Attribute/AttributeID/RelativeAttributeID.h"
@@ -25,6 +27,13 @@ class IndirectNode {
     uint16_t _size = InvalidSize;
     RelativeAttributeID _next_attribute;
 
+    // Node this indirect node last resolved to, valid while _resolved_epoch matches the indirect resolution epoch of
+    // its graph. Resolving may happen on any thread, so the epoch is cleared before and published after the other
+    // fields, and read on both sides of them.
+    std::atomic<IAGAttribute> _resolved_source = 0;
+    std::atomic<uint32_t> _resolved_offset = 0; // offset shifted left by one, with the low bit set if traverses mutable
+    std::atomic<uint32_t> _resolved_epoch = 0;
+
   protected:
     IndirectNode(WeakAttributeID source, bool traverses_contexts, uint32_t offset, std::optional<size_t> size,
                  bool is_mutable)
@@ -63,7 +72,36 @@ class IndirectNode {
     const RelativeAttributeID next_attribute() const { return _next_attribute; }
     void set_next_attribute(RelativeAttributeID next_attribute) { _next_attribute = next_attribute; }
 
+    // Callers must also invalidate the indirect resolutions of the graph
     void modify(WeakAttributeID source, size_t offset);
+
+    // MARK: Resolved source
+
+    /// Reads the source resolved during epoch, returning false if there is none or it is being replaced.
+    bool load_resolved_source(uint32_t epoch, AttributeID &source_out, uint32_t &offset_out,
+                              bool &traverses_mutable_out) const {
+        if (_resolved_epoch.load(std::memory_order_acquire) != epoch) {
+            return false;
+        }
+        IAGAttribute source = _resolved_source.load(std::memory_order_relaxed);
+        uint32_t offset = _resolved_offset.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_resolved_epoch.load(std::memory_order_relaxed) != epoch) {
+            return false;
+        }
+        source_out = AttributeID(source);
+        offset_out = offset >> 1;
+        traverses_mutable_out = offset & 1;
+        return true;
+    };
+
+    void store_resolved_source(uint32_t epoch, AttributeID source, uint32_t offset, bool traverses_mutable) {
+        _resolved_epoch.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _resolved_source.store(source, std::memory_order_relaxed);
+        _resolved_offset.store(offset << 1 | (traverses_mutable ? 1 : 0), std::memory_order_relaxed);
+        _resolved_epoch.store(epoch, std::memory_order_release);
+    };
 };
 
 class MutableIndirectNode : public IndirectNode {
@@ -74,6 +112,10 @@ class MutableIndirectNode : public IndirectNode {
     WeakAttributeID _initial_source;
     uint32_t _initial_offset;
 
+    // Generation of the last dirty propagation that visited this node, shifted left by one, with the low bit set if
+    // main thread state was propagated
+    uint32_t _propagation_stamp = 0;
+
   public:
     MutableIndirectNode(WeakAttributeID source, bool traverses_contexts, uint32_t offset, std::optional<size_t> size,
                         WeakAttributeID initial_source, uint32_t initial_offset)
@@ -81,6 +123,7 @@ class MutableIndirectNode : public IndirectNode {
           _initial_offset(initial_offset) {}
 
     const AttributeID &dependency() const { return _dependency; };
+    // Callers must also invalidate the indirect resolutions of the graph
     void set_dependency(const AttributeID &dependency) { _dependency = dependency; };
 
     WeakAttributeID initial_source() { return _initial_source; };
@@ -88,6 +131,9 @@ class MutableIndirectNode : public IndirectNode {
 
     data::vector<OutputEdge> &output_edges() { return _output_edges; };
     const data::vector<OutputEdge> &output_edges() const { return _output_edges; };
+
+    uint32_t propagation_stamp() const { return _propagation_stamp; };
+    void set_propagation_stamp(uint32_t stamp) { _propagation_stamp = stamp; };
 };
 
 } // namespace IAG
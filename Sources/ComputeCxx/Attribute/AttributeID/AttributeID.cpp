@@ -50,8 +50,39 @@ OffsetAttributeID AttributeID::resolve(TraversalOptions options) const {
 }
 
 OffsetAttributeID AttributeID::resolve_slow(TraversalOptions options) const {
+    auto first_indirect_node = get_indirect_node();
+    Graph *graph = nullptr;
+    uint32_t epoch = 0;
+    if (first_indirect_node) {
+        // chains can't cross graphs, so only this graph's changes can invalidate the resolved source
+        if (auto subgraph = AttributeID(first_indirect_node).subgraph()) {
+            graph = subgraph->graph();
+            epoch = graph->indirect_resolution_epoch();
+        }
+    }
+    if (graph) {
+        AttributeID resolved_source;
+        uint32_t resolved_offset;
+        bool resolved_traverses_mutable;
+        // the chain hasn't changed since it was last resolved, and has no dependencies to update or expired
+        // references, so only stopping at a mutable reference can produce a different result
+        if (first_indirect_node->load_resolved_source(epoch, resolved_source, resolved_offset,
+                                                      resolved_traverses_mutable) &&
+            (!(options & TraversalOptions::SkipMutableReference) || !resolved_traverses_mutable)) {
+            graph->did_hit_indirect_resolution();
+            if (options & TraversalOptions::ReportIndirectionInOffset) {
+                resolved_offset += 1;
+            }
+            return OffsetAttributeID(resolved_source, resolved_offset);
+        }
+        graph->did_miss_indirect_resolution();
+    }
+
     AttributeID result = *this;
     uint32_t offset = 0;
+    uint32_t total_offset = 0;
+    bool traverses_mutable = false;
+    bool memoizable = graph != nullptr;
     while (auto indirect_node = result.get_indirect_node()) {
         if (offset == 0 && options & TraversalOptions::ReportIndirectionInOffset) {
             offset = 1;
@@ -62,6 +93,11 @@ OffsetAttributeID AttributeID::resolve_slow(TraversalOptions options) const {
                 return OffsetAttributeID(result, offset);
             }
 
+            traverses_mutable = true;
+            if (indirect_node->to_mutable().dependency()) {
+                memoizable = false;
+            }
+
             if (options & TraversalOptions::UpdateDependencies) {
                 auto dependency = indirect_node->to_mutable().dependency();
                 if (dependency) {
@@ -82,10 +118,19 @@ OffsetAttributeID AttributeID::resolve_slow(TraversalOptions options) const {
             }
         }
 
+        if (memoizable && indirect_node->source().expired()) {
+            memoizable = false;
+        }
+
         offset += indirect_node->offset();
+        total_offset += indirect_node->offset();
         result = indirect_node->source().identifier();
     }
 
+    if (memoizable && result.is_node() && total_offset <= IndirectNode::MaximumOffset) {
+        first_indirect_node->store_resolved_source(epoch, result, total_offset, traverses_mutable);
+    }
+
     if (options & TraversalOptions::AssertNotNil && !result.is_node()) {
         precondition_failure("invalid attribute id: %u", _value);
     }
@@ -0,0 +1,453 @@
+#include "LayoutCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <platform/image.h>
+#include <platform/once.h>
+#include <platform/sha.h>
+
+#include "Swift/ContextDescriptor.h"
+#include "Swift/Metadata.h"
+#include "Swift/MetadataVisitor.h"
+#include "ValueLayout.h"
+#include "Vector/Vector.h"
+
+namespace IAG {
+namespace LayoutDescriptor {
+
+namespace {
+
+constexpr char file_magic[8] = {'I', 'A', 'G', 'L', 'A', 'Y', 'T', 'S'};
+constexpr uint32_t file_version = 3;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pointer_size;
+    uint32_t num_entries;
+};
+
+enum class RecordKind : uint8_t {
+    Null = 0,
+    Trivial = 1,
+    Layout = 2,
+};
+
+struct FileRecord {
+    unsigned char signature[20];
+    unsigned char dependencies[20];
+    uint32_t size;
+    uint32_t stride;
+    uint8_t comparison_mode;
+    RecordKind kind;
+    uint16_t heap_mode;
+    uint32_t length;
+};
+
+PersistentCache *_shared_cache = nullptr;
+
+// Returns whether the signature of the type identifies it. The signature only covers nominal type descriptors, so a
+// tuple, function or existential anywhere in the generic arguments would let distinct types share it.
+bool is_signature_complete(const swift::metadata &type) {
+    auto metadata_queue = vector<const swift::metadata *, 8, uint64_t>();
+    auto generic_args = vector<swift::context_descriptor::generic_arg, 8, uint64_t>();
+
+    metadata_queue.push_back(&type);
+    while (metadata_queue.size() > 0) {
+        auto metadata = metadata_queue.back();
+        metadata_queue.pop_back();
+
+        auto descriptor = metadata->descriptor();
+        if (!descriptor) {
+            return false;
+        }
+
+        generic_args.clear();
+        descriptor->push_generic_args(*metadata, generic_args);
+        for (auto generic_arg : generic_args) {
+            if (generic_arg.is_pack) {
+                // types points to an array of metadata pointers
+                auto pack_types = reinterpret_cast<const swift::metadata *const *>(generic_arg.types);
+                for (uint64_t i = 0; i < generic_arg.num_types; i++) {
+                    metadata_queue.push_back(pack_types[i]);
+                }
+            } else {
+                for (uint64_t i = 0; i < generic_arg.num_types; i++) {
+                    metadata_queue.push_back(&generic_arg.types[i]);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Collects the descriptors of every type a layout can be built from, i.e. the type itself and, recursively, the types
+// of its stored fields, enum payloads and superclasses. A layout is only as current as the images defining these.
+class DependencyVisitor : public swift::metadata_visitor {
+  private:
+    vector<const swift::metadata *, 16, uint64_t> _visited;
+
+  public:
+    vector<const void *, 16, uint64_t> descriptors;
+
+    void visit_type(const swift::metadata &type) {
+        if (std::find(_visited.begin(), _visited.end(), &type) != _visited.end()) {
+            return;
+        }
+        _visited.push_back(&type);
+
+        if (auto descriptor = type.descriptor()) {
+            descriptors.push_back(descriptor);
+        }
+        type.visit(*this);
+    }
+
+    void visit_heap_type(const swift::metadata &type, HeapMode heap_mode) {
+        _visited.push_back(&type);
+
+        // the field offsets of a class depend on its superclasses
+        const ::swift::Metadata *class_type = type.base();
+        while (class_type && class_type->isClassObject()) {
+            if (auto descriptor = reinterpret_cast<const swift::metadata *>(class_type)->descriptor()) {
+                descriptors.push_back(descriptor);
+            }
+            class_type = reinterpret_cast<const ::swift::Metadata *>(
+                static_cast<const ::swift::ClassMetadata *>(class_type)->Superclass);
+        }
+        type.visit_heap(*this, heap_mode == HeapMode::Locals ? HeapMode::Locals
+                                                             : HeapMode::Class | HeapMode::GenericLocals);
+    }
+
+    // keep walking past anything that can't be visited, its layout doesn't depend on any further types
+    virtual bool unknown_result() override { return true; }
+
+    virtual bool visit_element(const swift::metadata &type, const swift::metadata::ref_kind kind,
+                               size_t element_offset, size_t element_size) override {
+        visit_type(type);
+        return true;
+    }
+
+    virtual bool visit_case(const swift::metadata &type, const swift::field_record &field, uint32_t index) override {
+        auto mangled_type_name = field.MangledTypeName.get();
+        if (auto field_type =
+                mangled_type_name != nullptr ? type.mangled_type_name_ref(mangled_type_name, false, nullptr) : nullptr) {
+            visit_type(*field_type);
+        }
+        return true;
+    }
+};
+
+// Digests the images and offsets of the descriptors the layout of type can be built from, so that rebuilding the image
+// of any field type, not only of the type itself or its generic arguments, changes the key.
+void make_dependencies_digest(const swift::metadata &type, HeapMode heap_mode,
+                              std::array<unsigned char, 20> &digest_out) {
+    DependencyVisitor visitor;
+    if (heap_mode == HeapMode::NonHeap) {
+        visitor.visit_type(type);
+    } else {
+        visitor.visit_heap_type(type, heap_mode);
+    }
+
+    auto infos = vector<platform_image_info_t, 16, uint64_t>();
+    infos.resize(visitor.descriptors.size());
+    platform_image_infos_for_addresses((unsigned)visitor.descriptors.size(), visitor.descriptors.data(), infos.data());
+
+    auto context = PLATFORM_SHA1_CTX();
+    PLATFORM_SHA1_Init(&context);
+
+    const char prefix[] = "IAGLayoutDependencies";
+    PLATFORM_SHA1_Update(&context, prefix, sizeof(prefix));
+    for (auto &info : infos) {
+        PLATFORM_SHA1_Update(&context, info.identifier, sizeof(info.identifier));
+        PLATFORM_SHA1_Update(&context, &info.offset, sizeof(info.offset));
+    }
+
+    static_assert(PLATFORM_SHA1_DIGEST_LENGTH == sizeof(digest_out));
+    PLATFORM_SHA1_Final(digest_out.data(), &context);
+}
+
+} // namespace
+
+size_t PersistentCache::KeyHash::operator()(const Key &key) const {
+    // the signature is already a SHA1 digest
+    size_t hash;
+    memcpy(&hash, key.signature.data(), sizeof(hash));
+    return hash ^ (size_t(key.size) << 32) ^ (size_t(key.comparison_mode) << 8) ^ size_t(key.heap_mode);
+}
+
+PersistentCache::PersistentCache(const char *path) : _path(path) { read(); }
+
+PersistentCache *PersistentCache::shared() {
+    static platform_once_t once;
+    platform_once(&once, []() {
+        const char *path = getenv("IAG_LAYOUT_CACHE");
+        if (path && *path) {
+            _shared_cache = new PersistentCache(strdup(path));
+            atexit([]() { _shared_cache->write(); });
+        }
+    });
+    return _shared_cache;
+}
+
+bool PersistentCache::make_key(const swift::metadata &type, IAGComparisonMode comparison_mode, HeapMode heap_mode,
+                               Key &key_out) {
+    auto signature = static_cast<const unsigned char *>(type.signature());
+    if (!signature || !is_signature_complete(type)) {
+        return false;
+    }
+    memcpy(key_out.signature.data(), signature, key_out.signature.size());
+    make_dependencies_digest(type, heap_mode, key_out.dependencies);
+    key_out.size = uint32_t(type.vw_size());
+    key_out.stride = uint32_t(type.vw_stride());
+    key_out.comparison_mode = comparison_mode;
+    key_out.heap_mode = heap_mode;
+    return true;
+}
+
+// Returns whether the layout can be reused by another process, i.e. it doesn't embed any metadata, witness table
+// or nested layout addresses.
+bool PersistentCache::is_relocatable(ValueLayout layout) {
+    ValueLayoutReader reader = ValueLayoutReader(layout);
+    while (true) {
+        switch (reader.read_kind()) {
+        case ValueLayoutEntryKind::End:
+            return true;
+        case ValueLayoutEntryKind::HeapRef:
+        case ValueLayoutEntryKind::Function:
+            continue;
+        case ValueLayoutEntryKind::Equals:
+        case ValueLayoutEntryKind::Indirect:
+        case ValueLayoutEntryKind::Existential:
+        case ValueLayoutEntryKind::Nested:
+        case ValueLayoutEntryKind::CompactNested:
+        case ValueLayoutEntryKind::EnumStartVariadic:
+        case ValueLayoutEntryKind::EnumStart0:
+        case ValueLayoutEntryKind::EnumStart1:
+        case ValueLayoutEntryKind::EnumStart2:
+        case ValueLayoutEntryKind::EnumContinueVariadic:
+        case ValueLayoutEntryKind::EnumContinue0:
+        case ValueLayoutEntryKind::EnumContinue1:
+        case ValueLayoutEntryKind::EnumContinue2:
+        case ValueLayoutEntryKind::EnumContinue3:
+        case ValueLayoutEntryKind::EnumContinue4:
+        case ValueLayoutEntryKind::EnumContinue5:
+        case ValueLayoutEntryKind::EnumContinue6:
+        case ValueLayoutEntryKind::EnumContinue7:
+        case ValueLayoutEntryKind::EnumContinue8:
+        case ValueLayoutEntryKind::EnumEnd:
+            return false;
+        default:
+            continue;
+        }
+    }
+}
+
+bool PersistentCache::lookup(const swift::metadata &type, IAGComparisonMode comparison_mode, HeapMode heap_mode,
+                             ValueLayout _Nullable *layout_out) {
+    Key key;
+    if (!make_key(type, comparison_mode, heap_mode, key)) {
+        return false;
+    }
+
+    platform_lock_lock(&_lock);
+    auto iter = _entries.find(key);
+    bool found = iter != _entries.end() && iter->second.persisted;
+    if (found) {
+        iter->second.used = true;
+        *layout_out = iter->second.layout;
+    }
+    platform_lock_unlock(&_lock);
+
+    return found;
+}
+
+void PersistentCache::insert(const swift::metadata &type, IAGComparisonMode comparison_mode, HeapMode heap_mode,
+                             ValueLayout layout) {
+    size_t layout_length = 0;
+    if (layout > ValueLayoutTrivial) {
+        if (!is_relocatable(layout)) {
+            return;
+        }
+        layout_length = length(layout);
+    }
+
+    Key key;
+    if (!make_key(type, comparison_mode, heap_mode, key)) {
+        return;
+    }
+
+    platform_lock_lock(&_lock);
+    _entries[key] = {layout, layout_length, true, false};
+    _modified = true;
+    platform_lock_unlock(&_lock);
+}
+
+void PersistentCache::read() {
+    int fd = open(_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t)sizeof(FileHeader)) {
+        close(fd);
+        return;
+    }
+
+    size_t size = file_stat.st_size;
+    void *mapped_file = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped_file == MAP_FAILED) {
+        return;
+    }
+
+    auto bytes = static_cast<const unsigned char *>(mapped_file);
+
+    FileHeader header;
+    memcpy(&header, bytes, sizeof(FileHeader));
+    if (memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version ||
+        header.pointer_size != sizeof(void *)) {
+        munmap(mapped_file, size);
+        return;
+    }
+
+    size_t offset = sizeof(FileHeader);
+    for (uint32_t i = 0; i < header.num_entries; ++i) {
+        FileRecord record;
+        if (size - offset < sizeof(FileRecord)) {
+            break;
+        }
+        memcpy(&record, bytes + offset, sizeof(FileRecord));
+        offset += sizeof(FileRecord);
+
+        if (size - offset < record.length) {
+            break;
+        }
+
+        const unsigned char *record_bytes = bytes + offset;
+        offset += record.length;
+
+        ValueLayout layout = nullptr;
+        switch (record.kind) {
+        case RecordKind::Null:
+            break;
+        case RecordKind::Trivial:
+            layout = ValueLayoutTrivial;
+            break;
+        case RecordKind::Layout:
+            // layouts are terminated by an End entry, which must be inside the record
+            if (record.length == 0 || record_bytes[record.length - 1] != (unsigned char)ValueLayoutEntryKind::End) {
+                continue;
+            }
+            layout = record_bytes;
+            break;
+        default:
+            continue;
+        }
+
+        Key key;
+        memcpy(key.signature.data(), record.signature, key.signature.size());
+        memcpy(key.dependencies.data(), record.dependencies, key.dependencies.size());
+        key.size = record.size;
+        key.stride = record.stride;
+        key.comparison_mode = IAGComparisonMode(record.comparison_mode);
+        key.heap_mode = HeapMode(record.heap_mode);
+        _entries[key] = {layout, record.length, false, true};
+    }
+
+    _mapped_file = mapped_file;
+    _mapped_size = size;
+}
+
+void PersistentCache::write() {
+    platform_lock_lock(&_lock);
+
+    // Rewrite only when something was added, keeping the entries this launch used so stale ones age out
+    if (!_modified) {
+        platform_lock_unlock(&_lock);
+        return;
+    }
+
+    auto data = vector<unsigned char, 0, uint64_t>();
+    auto append = [&data](const void *bytes, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            data.push_back(static_cast<const unsigned char *>(bytes)[i]);
+        }
+    };
+
+    FileHeader header = {};
+    memcpy(header.magic, file_magic, sizeof(file_magic));
+    header.version = file_version;
+    header.pointer_size = sizeof(void *);
+    append(&header, sizeof(header));
+
+    uint32_t num_entries = 0;
+    for (auto &[key, entry] : _entries) {
+        if (!entry.used) {
+            continue;
+        }
+
+        FileRecord record = {};
+        memcpy(record.signature, key.signature.data(), key.signature.size());
+        memcpy(record.dependencies, key.dependencies.data(), key.dependencies.size());
+        record.size = key.size;
+        record.stride = key.stride;
+        record.comparison_mode = key.comparison_mode;
+        record.heap_mode = uint16_t(key.heap_mode);
+        if (entry.layout == nullptr) {
+            record.kind = RecordKind::Null;
+        } else if (entry.layout == ValueLayoutTrivial) {
+            record.kind = RecordKind::Trivial;
+        } else {
+            record.kind = RecordKind::Layout;
+            record.length = uint32_t(entry.length);
+        }
+        append(&record, sizeof(record));
+        if (record.kind == RecordKind::Layout) {
+            append(entry.layout, entry.length);
+        }
+        num_entries += 1;
+    }
+    header.num_entries = num_entries;
+    memcpy(data.data(), &header, sizeof(header));
+
+    platform_lock_unlock(&_lock);
+
+    // Write to a temporary file and rename it, so concurrent launches never read a partial file
+    size_t temporary_path_length = strlen(_path) + 16;
+    char *temporary_path = (char *)alloca(temporary_path_length);
+    snprintf(temporary_path, temporary_path_length, "%s.%d", _path, (int)getpid());
+
+    int fd = open(temporary_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return;
+    }
+
+    const unsigned char *remaining = data.data();
+    size_t remaining_size = data.size();
+    while (remaining_size > 0) {
+        ssize_t written = ::write(fd, remaining, remaining_size);
+        if (written <= 0) {
+            close(fd);
+            unlink(temporary_path);
+            return;
+        }
+        remaining += written;
+        remaining_size -= written;
+    }
+    close(fd);
+
+    if (rename(temporary_path, _path) != 0) {
+        unlink(temporary_path);
+    }
+}
+
+} // namespace LayoutDescriptor
+} // namespace IAG
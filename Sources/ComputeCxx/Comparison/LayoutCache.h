@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <unordered_map>
+
+#include <platform/lock.h>
+
+#include "ComputeCxx/IAGBase.h"
+#include "LayoutDescriptor.h"
+
+IAG_ASSUME_NONNULL_BEGIN
+
+namespace IAG {
+
+namespace swift {
+class metadata;
+}
+
+namespace LayoutDescriptor {
+
+/// An on-disk cache of layouts keyed by type signature, so that layouts built by a previous launch of the same
+/// binaries don't have to be rebuilt.
+///
+/// Enabled by setting IAG_LAYOUT_CACHE to a file path. Only layouts that contain no addresses are stored, and only for
+/// types whose signature covers every generic argument. The signature covers the images that define the type and its
+/// generic arguments, and the key also digests the images that define the types of its fields, recursively. Entries
+/// built from a rebuilt image are never looked up again, and are dropped when the file is rewritten on exit.
+class PersistentCache {
+  private:
+    struct Key {
+        std::array<unsigned char, 20> signature;
+        std::array<unsigned char, 20> dependencies;
+        uint32_t size;
+        uint32_t stride;
+        IAGComparisonMode comparison_mode;
+        HeapMode heap_mode;
+
+        bool operator==(const Key &other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    struct Entry {
+        ValueLayout _Nullable layout;
+        size_t length;
+        bool used;
+        bool persisted; // read from the file, entries inserted by this launch are only written
+    };
+
+    platform_lock _lock = PLATFORM_LOCK_INIT;
+    const char *_path;
+    void *_Nullable _mapped_file = nullptr;
+    size_t _mapped_size = 0;
+    std::unordered_map<Key, Entry, KeyHash> _entries;
+    bool _modified = false;
+
+    static bool make_key(const swift::metadata &type, IAGComparisonMode comparison_mode, HeapMode heap_mode,
+                         Key &key_out);
+    static bool is_relocatable(ValueLayout layout);
+
+    void read();
+    void write();
+
+  public:
+    PersistentCache(const char *path);
+
+    static PersistentCache *_Nullable shared();
+
+    bool lookup(const swift::metadata &type, IAGComparisonMode comparison_mode, HeapMode heap_mode,
+                ValueLayout _Nullable *_Nonnull layout_out);
+    void insert(const swift::metadata &type, IAGComparisonMode comparison_mode, HeapMode heap_mode,
+                ValueLayout _Nullable layout);
+};
+
+} // namespace LayoutDescriptor
+} // namespace IAG
+
+IAG_ASSUME_NONNULL_END
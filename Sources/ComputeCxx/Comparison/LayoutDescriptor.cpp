@@ -1,8 +1,18 @@
 #include "LayoutDescriptor.h"
 
+#include <bit>
 #include <cstring> 
 #include <variant>
 #include <stdio.h>
+#if !TARGET_OS_MAC
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include <platform/lock.h>
 #include <platform/once.h>
@@ -12,6 +22,7 @@
 #include "Compare.h"
 #include "ComputeCxx/IAGComparison.h"
 #include "Graph/Graph.h"
+#include "LayoutCache.h"
 #include "Swift/Metadata.h"
 #include "Time/Time.h"
 #include "ValueLayout.h"
@@ -88,12 +99,13 @@ class TypeDescriptorCache {
     ValueLayout insert_sync(void *key, const swift::metadata &type, IAGComparisonMode comparison_mode,
                             LayoutDescriptor::HeapMode heap_mode);
     
-#if TARGET_OS_MAC
-    void insert_async(void *key, const swift::metadata &type, IAGComparisonMode comparison_mode,
-                      LayoutDescriptor::HeapMode heap_mode, uint32_t priority);
+    ValueLayout insert_async(void *key, const swift::metadata &type, IAGComparisonMode comparison_mode,
+                             LayoutDescriptor::HeapMode heap_mode, uint32_t priority);
     
     static void drain_queue(void *cache);
-#endif
+
+    static void persist(const swift::metadata &type, IAGComparisonMode comparison_mode,
+                        LayoutDescriptor::HeapMode heap_mode, ValueLayout layout);
 };
 
 TypeDescriptorCache *TypeDescriptorCache::_shared_cache = nullptr;
@@ -125,9 +137,22 @@ ValueLayout TypeDescriptorCache::fetch(const swift::metadata &type, IAGCompariso
     }
 
     _cache_miss_count += 1;
+    bool persistent = _modes.size() == 0;
     unlock();
 
-#if TARGET_OS_MAC
+    // Layouts persisted by a previous launch are cheap to restore, so don't defer them to the async queue
+    if (persistent) {
+        if (auto persistent_cache = LayoutDescriptor::PersistentCache::shared()) {
+            ValueLayout persisted_layout = nullptr;
+            if (persistent_cache->lookup(type, comparison_mode, heap_mode, &persisted_layout)) {
+                lock();
+                _table.insert((void *)key, persisted_layout);
+                unlock();
+                return persisted_layout;
+            }
+        }
+    }
+
     static bool async_layouts = []() {
         char *result = getenv("IAG_ASYNC_LAYOUTS");
         if (result) {
@@ -140,11 +165,7 @@ ValueLayout TypeDescriptorCache::fetch(const swift::metadata &type, IAGCompariso
         return insert_sync(key, type, comparison_mode, heap_mode);
     }
 
-    insert_async(key, type, comparison_mode, heap_mode, priority);
-    return nullptr;
-#else
-    return insert_sync(key, type, comparison_mode, heap_mode);
-#endif
+    return insert_async(key, type, comparison_mode, heap_mode, priority);
 }
 
 ValueLayout TypeDescriptorCache::insert_sync(void *key, const swift::metadata &type, IAGComparisonMode comparison_mode,
@@ -166,14 +187,20 @@ ValueLayout TypeDescriptorCache::insert_sync(void *key, const swift::metadata &t
     }
 
     _table.insert((void *)key, layout);
+    bool persistent = _modes.size() == 0;
     unlock();
+
+    if (persistent) {
+        persist(type, comparison_mode, heap_mode, layout);
+    }
     return layout;
 }
 
-#if TARGET_OS_MAC
-
-void TypeDescriptorCache::insert_async(void *key, const swift::metadata &type, IAGComparisonMode comparison_mode,
-                                       LayoutDescriptor::HeapMode heap_mode, uint32_t priority) {
+// Queues the layout to be created in the background and returns null, unless no background thread can be started, in
+// which case the queue is drained on the calling thread and the layout is returned.
+ValueLayout TypeDescriptorCache::insert_async(void *key, const swift::metadata &type,
+                                              IAGComparisonMode comparison_mode, LayoutDescriptor::HeapMode heap_mode,
+                                              uint32_t priority) {
     lock();
     _table.insert((void *)key, nullptr);
 
@@ -187,11 +214,51 @@ void TypeDescriptorCache::insert_async(void *key, const swift::metadata &type, I
 
     if (!_async_queue_running) {
         _async_queue_running = true;
+#if TARGET_OS_MAC
         dispatch_queue_global_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0);
         dispatch_async_f(queue, this, drain_queue);
+#else
+        // Without libdispatch, drain the queue on a detached low priority thread. It exits once the queue is empty
+        // and a new one is started by the next insertion.
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+        pthread_t thread;
+        int error = pthread_create(
+            &thread, &attributes,
+            [](void *cache) -> void * {
+#if defined(__linux__)
+                // lowers the priority of this thread only
+                (void)nice(10);
+#endif
+                drain_queue(cache);
+                return nullptr;
+            },
+            this);
+        pthread_attr_destroy(&attributes);
+
+        if (error != 0) {
+            unlock();
+            drain_queue(this);
+
+            lock();
+            ValueLayout layout = (ValueLayout)_table.lookup(key, nullptr);
+            unlock();
+            return layout;
+        }
+#endif
     }
 
     unlock();
+    return nullptr;
+}
+
+void TypeDescriptorCache::persist(const swift::metadata &type, IAGComparisonMode comparison_mode,
+                                  LayoutDescriptor::HeapMode heap_mode, ValueLayout layout) {
+    if (auto persistent_cache = LayoutDescriptor::PersistentCache::shared()) {
+        persistent_cache->insert(type, comparison_mode, heap_mode, layout);
+    }
 }
 
 void TypeDescriptorCache::drain_queue(void *context) {
@@ -211,8 +278,12 @@ void TypeDescriptorCache::drain_queue(void *context) {
         ValueLayout layout = (ValueLayout)cache->_table.lookup(key, &found);
 
         if (layout == nullptr && found != nullptr) {
+            bool persistent = cache->_modes.size() == 0;
             cache->unlock();
             layout = LayoutDescriptor::make_layout(*entry.type, entry.comparison_mode, entry.heap_mode);
+            if (persistent) {
+                persist(*entry.type, entry.comparison_mode, entry.heap_mode, layout);
+            }
             cache->lock();
             cache->_table.insert(key, layout);
         }
@@ -237,8 +308,6 @@ void TypeDescriptorCache::drain_queue(void *context) {
     cache->unlock();
 }
 
-#endif
-
 } // namespace
 
 #pragma mark - LayoutDescriptor
@@ -441,45 +510,132 @@ bool compare_bytes_top_level(const unsigned char *lhs, const unsigned char *rhs,
     return result;
 }
 
-bool compare_bytes(const unsigned char *lhs, const unsigned char *rhs, size_t size, size_t *failure_location) {
-    if (size == 0) {
-        return true;
-    }
+namespace {
+
+// Each mismatch function returns the index of the first differing byte, or size if the ranges are equal.
 
+size_t mismatch_scalar(const unsigned char *lhs, const unsigned char *rhs, size_t size) {
     size_t location = 0;
-    size_t remaining_size = size;
-
-    // If both aligned to 8 bytes, compare 8 bytes at a time
-    if ((((uintptr_t)lhs | (uintptr_t)rhs) & 7) == 0) {
-        while (remaining_size >= 8) {
-            if (*(uint64_t *)lhs != *(uint64_t *)rhs) {
-                if (failure_location) {
-                    *failure_location = location;
-                }
-                return false;
-            }
-            lhs += 8;
-            rhs += 8;
-            location += 8;
-            remaining_size -= 8;
+
+    // Compare 8 bytes at a time, using unaligned loads
+    while (size - location >= 8) {
+        uint64_t lhs_word, rhs_word;
+        memcpy(&lhs_word, lhs + location, 8);
+        memcpy(&rhs_word, rhs + location, 8);
+        if (uint64_t difference = lhs_word ^ rhs_word) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return location + (std::countr_zero(difference) / 8);
+#else
+            return location + (std::countl_zero(difference) / 8);
+#endif
         }
+        location += 8;
     }
 
     // Compare one byte at a time
-    while (remaining_size > 0) {
-        if (*(uint8_t *)lhs != *(uint8_t *)rhs) {
-            if (failure_location) {
-                *failure_location = location;
-            }
-            return false;
+    while (location < size) {
+        if (lhs[location] != rhs[location]) {
+            return location;
         }
-        lhs += 1;
-        rhs += 1;
         location += 1;
-        remaining_size -= 1;
     }
 
-    return true;
+    return size;
+}
+
+#if defined(__x86_64__)
+
+size_t mismatch_sse2(const unsigned char *lhs, const unsigned char *rhs, size_t size) {
+    size_t location = 0;
+    while (size - location >= 16) {
+        __m128i lhs_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + location));
+        __m128i rhs_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + location));
+        uint32_t equal_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(lhs_bytes, rhs_bytes));
+        if (equal_mask != 0xffff) {
+            return location + std::countr_zero(~equal_mask);
+        }
+        location += 16;
+    }
+    return location + mismatch_scalar(lhs + location, rhs + location, size - location);
+}
+
+__attribute__((target("avx2"))) size_t mismatch_avx2(const unsigned char *lhs, const unsigned char *rhs,
+                                                     size_t size) {
+    size_t location = 0;
+    while (size - location >= 32) {
+        __m256i lhs_bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + location));
+        __m256i rhs_bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + location));
+        uint32_t equal_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs_bytes, rhs_bytes));
+        if (equal_mask != 0xffffffff) {
+            return location + std::countr_zero(~equal_mask);
+        }
+        location += 32;
+    }
+    return location + mismatch_sse2(lhs + location, rhs + location, size - location);
+}
+
+#elif defined(__aarch64__)
+
+size_t mismatch_neon(const unsigned char *lhs, const unsigned char *rhs, size_t size) {
+    size_t location = 0;
+    while (size - location >= 16) {
+        uint8x16_t equal_bytes = vceqq_u8(vld1q_u8(lhs + location), vld1q_u8(rhs + location));
+        if (vminvq_u8(equal_bytes) != 0xff) {
+            // narrow each byte's result to 4 bits so the first mismatch can be found in a 64-bit mask
+            uint64_t equal_mask =
+                vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal_bytes), 4)), 0);
+            return location + (std::countr_zero(~equal_mask) / 4);
+        }
+        location += 16;
+    }
+    return location + mismatch_scalar(lhs + location, rhs + location, size - location);
+}
+
+#endif
+
+// Values shorter than a vector register aren't worth dispatching for
+constexpr size_t vector_compare_threshold = 32;
+
+using mismatch_function = size_t (*)(const unsigned char *lhs, const unsigned char *rhs, size_t size);
+
+mismatch_function vector_mismatch() {
+    static mismatch_function function = []() -> mismatch_function {
+        // IAG_VECTOR_COMPARE=0 keeps the scalar loop, e.g. to benchmark against it
+        char *vector_compare = getenv("IAG_VECTOR_COMPARE");
+        if (vector_compare && atoi(vector_compare) == 0) {
+            return mismatch_scalar;
+        }
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            return mismatch_avx2;
+        }
+        return mismatch_sse2;
+#elif defined(__aarch64__)
+        return mismatch_neon;
+#else
+        return mismatch_scalar;
+#endif
+    }();
+    return function;
+}
+
+} // namespace
+
+bool compare_bytes(const unsigned char *lhs, const unsigned char *rhs, size_t size, size_t *failure_location) {
+    if (size == 0) {
+        return true;
+    }
+
+    size_t location = size < vector_compare_threshold ? mismatch_scalar(lhs, rhs, size)
+                                                      : vector_mismatch()(lhs, rhs, size);
+    if (location == size) {
+        return true;
+    }
+
+    if (failure_location) {
+        *failure_location = location;
+    }
+    return false;
 }
 
 bool compare_heap_objects(const unsigned char *lhs, const unsigned char *rhs, IAGComparisonOptions options,
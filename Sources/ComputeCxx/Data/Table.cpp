@@ -1,7 +1,10 @@
 #include "Table.h"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cerrno>
+#include <pthread.h>
 #include <sys/mman.h>
 #if TARGET_OS_MAC
 #include <mach/mach.h>
@@ -43,37 +46,96 @@ std::unique_ptr<void, table::malloc_zone_deleter> table::alloc_persistent(size_t
     return std::unique_ptr<void, table::malloc_zone_deleter>(buffer);
 }
 
+namespace {
+
+bool reserves_data_space() {
+    static bool reserve_data_space = []() -> bool {
+        char *result = getenv("IAG_RESERVE_DATA_SPACE");
+        if (result) {
+            return atoi(result) != 0;
+        }
+        return false;
+    }();
+    return reserve_data_space;
+}
+
+bool uses_huge_pages() {
+    static bool huge_pages = []() -> bool {
+        char *result = getenv("IAG_HUGE_PAGES");
+        if (result) {
+            return atoi(result) != 0;
+        }
+        return false;
+    }();
+    return huge_pages;
+}
+
+// The whole 32-bit ptr space, reserved when IAG_RESERVE_DATA_SPACE is set
+constexpr size_t reserved_region_size = size_t(UINT32_MAX) + 1;
+
+} // namespace
+
 table::table() {
     constexpr vm_size_t initial_size = 32 * pages_per_map * page_size;
 
+    _vm_region_reserved = reserves_data_space();
+    if (_vm_region_reserved) {
+#if !TARGET_OS_MAC
+        _vm_region_fd = -1;
+#endif
+        // Reserve the address space without committing it, so that the region grows in place and ptr_base never
+        // changes. Pages are committed by grow_region().
+        void *region = mmap(nullptr, reserved_region_size, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+        if (region == MAP_FAILED) {
+            precondition_failure("memory reservation failure (%lu bytes, %u)", reserved_region_size, errno);
+        }
+        _vm_region_base_address = reinterpret_cast<vm_address_t>(region);
+        _vm_region_size = 0;
+        commit_region(initial_size);
+
+        IAGGraphVMRegionBaseAddress = region;
+
+        _ptr_base = reinterpret_cast<vm_address_t>(region) - page_size;
+        _ptr_max_offset = initial_size + page_size;
+    } else {
 #if TARGET_OS_MAC
-    void *region = mmap(nullptr, initial_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
-    if (region == MAP_FAILED) {
-        precondition_failure("memory allocation failure (%u bytes, %u)", initial_size, errno);
-    }
+        void *region = mmap(nullptr, initial_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (region == MAP_FAILED) {
+            precondition_failure("memory allocation failure (%u bytes, %u)", initial_size, errno);
+        }
 #else
-    _vm_region_fd = memfd_create("IAGGraphVMRegion", MFD_CLOEXEC);
-    if (_vm_region_fd < 0) {
-        precondition_failure("memfd_create failure (%u)", errno);
-    }
+        _vm_region_fd = memfd_create("IAGGraphVMRegion", MFD_CLOEXEC);
+        if (_vm_region_fd < 0) {
+            precondition_failure("memfd_create failure (%u)", errno);
+        }
 
-    if (ftruncate(_vm_region_fd, initial_size) != 0) {
-        precondition_failure("ftruncate failure (%u bytes, %u)", initial_size, errno);
-    }
+        if (ftruncate(_vm_region_fd, initial_size) != 0) {
+            precondition_failure("ftruncate failure (%u bytes, %u)", initial_size, errno);
+        }
     
-    void *region = mmap(nullptr, initial_size, PROT_READ | PROT_WRITE, MAP_SHARED, _vm_region_fd, 0);
-    if (region == MAP_FAILED) {
-        precondition_failure("memory allocation failure (%u bytes, %u)", initial_size, errno);
-    }
+        void *region = mmap(nullptr, initial_size, PROT_READ | PROT_WRITE, MAP_SHARED, _vm_region_fd, 0);
+        if (region == MAP_FAILED) {
+            precondition_failure("memory allocation failure (%u bytes, %u)", initial_size, errno);
+        }
 #endif
 
-    _vm_region_base_address = reinterpret_cast<vm_address_t>(region);
-    _vm_region_size = initial_size;
+        _vm_region_base_address = reinterpret_cast<vm_address_t>(region);
+        _vm_region_size = initial_size;
 
-    IAGGraphVMRegionBaseAddress = region;
+        IAGGraphVMRegionBaseAddress = region;
 
-    _ptr_base = reinterpret_cast<vm_address_t>(region) - page_size;
-    _ptr_max_offset = initial_size + page_size;
+        _ptr_base = reinterpret_cast<vm_address_t>(region) - page_size;
+        _ptr_max_offset = initial_size + page_size;
+    }
+
+    // Reserved but only committed as pages are touched
+    constexpr size_t page_seeds_size = max_pages * sizeof(std::atomic<uint32_t>);
+    void *page_seeds =
+        mmap(nullptr, page_seeds_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+    if (page_seeds == MAP_FAILED) {
+        precondition_failure("memory allocation failure (%u bytes, %u)", page_seeds_size, errno);
+    }
+    _page_seeds = reinterpret_cast<std::atomic<uint32_t> *>(page_seeds);
 
     if (!_malloc_zone) {
         _malloc_zone = malloc_create_zone(0, 0);
@@ -82,8 +144,11 @@ table::table() {
 }
 
 table::~table() {
+    munmap(_page_seeds, max_pages * sizeof(std::atomic<uint32_t>));
 #if !TARGET_OS_MAC
-    close(_vm_region_fd);
+    if (_vm_region_fd >= 0) {
+        close(_vm_region_fd);
+    }
 #endif
     if (_malloc_zone) {
         malloc_destroy_zone(_malloc_zone);
@@ -96,6 +161,20 @@ void table::unlock() { platform_lock_unlock(&_lock); }
 
 #pragma mark - Region
 
+void table::commit_region(uint64_t new_size) {
+    void *committed_address = reinterpret_cast<void *>(_vm_region_base_address + _vm_region_size);
+    size_t committed_size = new_size - _vm_region_size;
+    if (mprotect(committed_address, committed_size, PROT_READ | PROT_WRITE) != 0) {
+        precondition_failure("memory allocation failure (%lu bytes, %u)", committed_size, errno);
+    }
+#ifdef MADV_HUGEPAGE
+    if (uses_huge_pages()) {
+        madvise(committed_address, committed_size, MADV_HUGEPAGE);
+    }
+#endif
+    _vm_region_size = static_cast<uint32_t>(new_size);
+}
+
 void table::grow_region() {
     uint64_t new_size = 4 * _vm_region_size;
 
@@ -104,6 +183,13 @@ void table::grow_region() {
         precondition_failure("exhausted data space");
     }
 
+    if (_vm_region_reserved) {
+        // grows in place, so existing pointers into the region stay valid
+        commit_region(new_size);
+        _ptr_max_offset = _vm_region_size + page_size;
+        return;
+    }
+
 #if TARGET_OS_MAC
     void *new_region = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
     if (new_region == MAP_FAILED) {
@@ -148,68 +234,164 @@ uint32_t table::make_zone_id() {
 
 #pragma mark - Pages
 
+// Each thread keeps a small magazine of single pages that are already reserved in the page maps, so that zones
+// growing one page at a time only take the table lock once per batch.
+class table::page_cache {
+  private:
+    static constexpr uint32_t capacity = 16;
+
+    static pthread_key_t _current_key;
+
+    ptr<page> _pages[capacity];
+    uint32_t _count = 0;
+
+    static void destroy(void *value) {
+        auto cache = reinterpret_cast<page_cache *>(value);
+        if (cache->_count) {
+            table &shared_table = table::shared();
+            shared_table._num_cached_pages.fetch_sub(cache->_count, std::memory_order_relaxed);
+            shared_table.lock();
+            while (cache->_count) {
+                shared_table.dealloc_pages_locked(cache->_pages[--cache->_count]);
+            }
+            shared_table.unlock();
+        }
+        delete cache;
+    }
+
+  public:
+    static page_cache &current() {
+        static platform_once_t make_key;
+        platform_once(&make_key, []() { pthread_key_create(&_current_key, destroy); });
+
+        auto cache = reinterpret_cast<page_cache *>(pthread_getspecific(_current_key));
+        if (!cache) {
+            cache = new page_cache();
+            pthread_setspecific(_current_key, cache);
+        }
+        return *cache;
+    }
+
+    ptr<page> pop(table &shared_table) {
+        if (_count == 0) {
+            shared_table.lock();
+            while (_count < capacity) {
+                _pages[_count++] = shared_table.alloc_pages_locked(nullptr, page_size);
+            }
+            shared_table.unlock();
+            shared_table._num_cached_pages.fetch_add(capacity - 1, std::memory_order_relaxed);
+        } else {
+            shared_table._num_cached_pages.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return _pages[--_count];
+    }
+};
+
+pthread_key_t table::page_cache::_current_key;
+
 ptr<page> table::alloc_page(zone *zone, uint32_t needed_size) {
+    if (needed_size == page_size) {
+        ptr<page> new_page = page_cache::current().pop(*this);
+
+        // The page is already reserved in the page maps with no published seed, so it can be handed to the zone
+        // without the lock.
+        new_page->next = nullptr;
+        new_page->in_use = sizeof(page);
+        new_page->bytes_list = 0;
+        new_page->const_bytes_list = 0;
+        new_page->zone = zone;
+        set_page_seed(new_page, zone->page_seed());
+        return new_page;
+    }
+
     lock();
+    ptr<page> new_page = alloc_pages_locked(zone, needed_size);
+    unlock();
 
-    uint32_t needed_pages = (needed_size + page_alignment_mask) / page_size;
+    return new_page;
+}
 
-    // assume we'll have to append a new page
-    uint32_t new_page_index = _page_maps.size() * pages_per_map;
+int32_t table::next_map_with_free_pages(uint32_t start_map_index, uint32_t end_map_index) const {
+    uint32_t word_index = start_map_index / 64;
+    uint64_t word = _free_map_summary[word_index] & (~uint64_t(0) << (start_map_index % 64));
+    while (true) {
+        if (word) {
+            uint32_t map_index = word_index * 64 + std::countr_zero(word);
+            return map_index < end_map_index ? int32_t(map_index) : -1;
+        }
+        word_index += 1;
+        if (word_index * 64 >= end_map_index) {
+            return -1;
+        }
+        word = _free_map_summary[word_index];
+    }
+}
 
-    // scan for consecutive free pages
-    if (!_page_maps.empty() && _num_used_pages <= _page_maps.size() * pages_per_map) {
+void table::update_free_map_summary(uint32_t map_index) {
+    uint32_t word_index = map_index / 64;
+    if (word_index == _free_map_summary.size()) {
+        _free_map_summary.push_back(0);
+    }
+    uint64_t bit = uint64_t(1) << (map_index % 64);
+    if (_page_maps[map_index].all()) {
+        _free_map_summary[word_index] &= ~bit;
+    } else {
+        _free_map_summary[word_index] |= bit;
+    }
+}
 
-        uint32_t start_map_index = _map_search_start;
-        for (int i = 0; i < _page_maps.size(); i++) {
-            int map_index = start_map_index + i;
-            if (map_index >= _page_maps.size()) {
-                map_index -= _page_maps.size(); // wrap around
-            }
-            
-            auto map_copy = std::bitset(_page_maps[map_index]);
-            page_map_type candidate_pages_map = map_copy.flip();
-            
-            bool found = false;
+uint32_t table::find_free_pages_locked(uint32_t needed_pages) {
+    uint32_t num_maps = _page_maps.size();
+
+    // scan maps that have at least one free page, starting from where the last search succeeded
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        uint32_t start_map_index = pass == 0 ? _map_search_start : 0;
+        uint32_t end_map_index = pass == 0 ? num_maps : std::min(_map_search_start, num_maps);
+
+        for (int32_t map_index = start_map_index < end_map_index
+                                     ? next_map_with_free_pages(start_map_index, end_map_index)
+                                     : -1;
+             map_index >= 0; map_index = map_index + 1 < end_map_index
+                                             ? next_map_with_free_pages(map_index + 1, end_map_index)
+                                             : -1) {
+            page_map_type candidate_pages_map = std::bitset(_page_maps[map_index]).flip();
             while (candidate_pages_map.any()) {
                 int candidate_bit = std::countr_zero(static_cast<uint64_t>(candidate_pages_map.to_ullong()));
-                
-                if (needed_pages > 1) {
-                    // scan ahead to find enough consecutive free pages
-                    bool sufficient_consecutive_pages = true;
-                    for (int j = 1; j < needed_pages; j++) {
-                        int next_page_index = (map_index * pages_per_map) + candidate_bit + j;
-                        int next_map_index = next_page_index / pages_per_map;
-                        if (next_map_index == _page_maps.size()) {
-                            // There are not enough maps, but the trailing pages are contiguous so this page is
-                            // usable
-                            found = true;
-                            break;
-                        }
-                        if (_page_maps[next_map_index].test(next_page_index % pages_per_map)) {
-                            // next page is used, remove this page from candidate_pages_map
-                            candidate_pages_map.reset(candidate_bit);
-                            sufficient_consecutive_pages = false;
-                            break;
-                        }
+
+                // scan ahead to find enough consecutive free pages
+                bool found = true;
+                for (int j = 1; j < needed_pages; j++) {
+                    int next_page_index = (map_index * pages_per_map) + candidate_bit + j;
+                    int next_map_index = next_page_index / pages_per_map;
+                    if (next_map_index == num_maps) {
+                        // There are not enough maps, but the trailing pages are contiguous so this page is
+                        // usable
+                        break;
+                    }
+                    if (_page_maps[next_map_index].test(next_page_index % pages_per_map)) {
+                        // next page is used, remove this page from candidate_pages_map
+                        candidate_pages_map.reset(candidate_bit);
+                        found = false;
+                        break;
                     }
-                    found = sufficient_consecutive_pages;
-                } else {
-                    // only need one page
-                    found = true;
                 }
 
                 if (found) {
-                    new_page_index = (map_index * pages_per_map) + candidate_bit;
                     _map_search_start = map_index;
-                    break;
+                    return (map_index * pages_per_map) + candidate_bit;
                 }
             }
-            if (found) {
-                break;
-            }
         }
     }
 
+    // append new pages
+    return num_maps * pages_per_map;
+}
+
+ptr<page> table::alloc_pages_locked(zone *_Nullable zone, uint32_t needed_size) {
+    uint32_t needed_pages = (needed_size + page_alignment_mask) / page_size;
+    uint32_t new_page_index = find_free_pages_locked(needed_pages);
+
     // update maps
     for (int i = 0; i < needed_pages; i++) {
         uint32_t page_index = new_page_index + i;
@@ -217,15 +399,12 @@ ptr<page> table::alloc_page(zone *zone, uint32_t needed_size) {
 
         if (map_index == _page_maps.size()) {
             _page_maps.push_back(0);
-            _page_metadata_maps.push_back(0);
         } else if (_page_maps[map_index] == 0) {
             make_pages_reusable(page_index, false);
         }
 
         _page_maps[map_index].set(page_index % pages_per_map);
-        if (i == 0) {
-            _page_metadata_maps[map_index].set(page_index % pages_per_map);
-        }
+        update_free_map_summary(map_index);
     }
 
     _num_used_pages += needed_pages;
@@ -237,24 +416,27 @@ ptr<page> table::alloc_page(zone *zone, uint32_t needed_size) {
 
     // ptr offsets are "one"-based, so that we can treat 0 as null.
     ptr<page> new_page = ptr<page>((new_page_index + 1) * page_size);
-    new_page->zone = zone;
     new_page->next = nullptr;
     new_page->total = (needed_size + page_alignment_mask) & ~page_alignment_mask;
     new_page->in_use = sizeof(page);
-    
+
     new_page->bytes_list = 0;
     new_page->const_bytes_list = 0;
 
-    unlock();
+    new_page->zone = zone;
+    set_page_seed(new_page, zone ? zone->page_seed() : 0);
 
     return new_page;
 }
 
-void table::dealloc_page_locked(ptr<page> page) {
+void table::dealloc_page_locked(ptr<page> page) { dealloc_pages_locked(page); }
+
+void table::dealloc_pages_locked(ptr<page> page) {
     int32_t total_bytes = page->total;
     int32_t num_pages = total_bytes / page_size;
 
     _num_used_pages -= num_pages;
+    set_page_seed(page, 0);
 
     // convert the page address (starts at 512) to an index (starts at 0)
     int32_t page_index = (page.offset() / page_size) - 1;
@@ -264,9 +446,7 @@ void table::dealloc_page_locked(ptr<page> page) {
         int32_t next_map_index = next_page_index / pages_per_map;
 
         _page_maps[next_map_index].reset(next_page_index % pages_per_map);
-        if (i == 0) {
-            _page_metadata_maps[next_map_index].reset(next_page_index % pages_per_map);
-        }
+        update_free_map_summary(next_map_index);
 
         if (_page_maps[next_map_index].none()) {
             make_pages_reusable(next_page_index, true);
@@ -303,22 +483,29 @@ void table::make_pages_reusable(uint32_t page_index, bool reusable) {
     _num_reusable_bytes += reusable ? mapped_pages_size : -mapped_pages_size;
 }
 
+void table::set_page_seed(ptr<page> page, uint32_t seed) {
+    uint32_t page_index = (page.offset() / page_size) - 1;
+    _page_seeds[page_index].store(seed, std::memory_order_release);
+}
+
+// Seeds are published per page by alloc_page(), dealloc_pages_locked() and zone::mark_deleted(), so this reads a
+// single word and never dereferences the page or its zone, which may be freed concurrently.
 uint64_t table::raw_page_seed(ptr<page> page) {
     page.assert_valid();
 
-    lock();
-
     uint32_t page_index = (page.offset() / page_size) - 1;
-    uint32_t map_index = page_index / pages_per_map;
-
-    uint64_t result = 0;
-    if (map_index < _page_metadata_maps.size() && _page_metadata_maps[map_index].test(page_index % pages_per_map)) {
-        auto raw_zone_info = page->zone->page_seed();
-        result = (uint64_t)raw_zone_info | ((uint64_t)0x01 << 32);
+    if (page_index >= max_pages) {
+        return 0;
     }
 
-    unlock();
+    uint32_t seed = _page_seeds[page_index].load(std::memory_order_acquire);
+    return seed ? (uint64_t)seed | ((uint64_t)0x01 << 32) : 0;
+}
 
+uint64_t table::mapped_bytes() {
+    lock();
+    uint64_t result = uint64_t(_page_maps.size()) * pages_per_map * page_size;
+    unlock();
     return result;
 }
 
@@ -327,7 +514,7 @@ uint64_t table::raw_page_seed(ptr<page> page) {
 void table::print() {
     lock();
     fprintf(stdout, "data::table %p:\n  %.2fKB allocated, %.2fKB used, %.2fKB reusable.\n", this,
-            (_ptr_max_offset - page_size) / 1024.0, (_num_used_pages * page_size) / 1024.0,
+            (_ptr_max_offset - page_size) / 1024.0, bytes() / 1024.0,
             _num_reusable_bytes / 1024.0);
     unlock();
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <bitset>
 #include <utility>
 
@@ -38,8 +39,10 @@ class table {
     platform_lock _lock = PLATFORM_LOCK_INIT;
     uint32_t _vm_region_size;
     uint32_t _ptr_max_offset;
+    bool _vm_region_reserved = false;
 
     uint32_t _num_used_pages = 0;
+    std::atomic<uint32_t> _num_cached_pages = 0; // reserved in the page maps but held free in page caches
     uint32_t _num_reusable_bytes = 0;
     uint32_t _map_search_start = 0;
 
@@ -51,7 +54,22 @@ class table {
     constexpr static unsigned int pages_per_map = 64;
     using page_map_type = std::bitset<pages_per_map>;
     vector<page_map_type, 0, uint32_t> _page_maps;
-    vector<page_map_type, 0, uint32_t> _page_metadata_maps;
+
+    // The raw seed of the zone owning each page that starts an allocation, or zero. Sized for the whole 32-bit ptr
+    // space up front so that it is never reallocated and can be read without the lock, see raw_page_seed().
+    constexpr static size_t max_pages = (size_t(UINT32_MAX) + 1) / 512;
+    std::atomic<uint32_t> *_page_seeds;
+
+    // One bit per page map, set while the map has at least one free page
+    vector<uint64_t, 0, uint32_t> _free_map_summary;
+
+    class page_cache;
+
+    int32_t next_map_with_free_pages(uint32_t start_map_index, uint32_t end_map_index) const;
+    void update_free_map_summary(uint32_t map_index);
+    uint32_t find_free_pages_locked(uint32_t needed_pages);
+    ptr<page> alloc_pages_locked(zone *_Nullable zone, uint32_t needed_size);
+    void dealloc_pages_locked(ptr<page> page);
 
   public:
     static table &ensure_shared();
@@ -68,6 +86,8 @@ class table {
     uint32_t ptr_max_offset() { return _ptr_max_offset; };
 
     // Region
+    vm_address_t vm_region_base_address() { return _vm_region_base_address; };
+    void commit_region(uint64_t new_size);
     void grow_region();
 
     // Zones
@@ -77,14 +97,17 @@ class table {
     ptr<page> alloc_page(zone *zone, uint32_t size);
     void dealloc_page_locked(ptr<page> page);
     void make_pages_reusable(uint32_t page_index, bool flag);
+    void set_page_seed(ptr<page> page, uint32_t seed);
     uint64_t raw_page_seed(ptr<page> page);
 
     // Printing
     void print();
 
     // Counters (TODO: what are these calculated from?)
-    uint64_t bytes() const { return _num_used_pages * 512; }
-    uint64_t max_bytes() const { return _num_used_pages * 512; }
+    uint64_t bytes() const { return (_num_used_pages - _num_cached_pages.load(std::memory_order_relaxed)) * 512; }
+    uint64_t max_bytes() const { return bytes(); }
+    uint64_t cached_bytes() const { return _num_cached_pages.load(std::memory_order_relaxed) * 512; }
+    uint64_t mapped_bytes();
 };
 
 } // namespace data
@@ -110,6 +110,7 @@ template <typename T> class vector {
         }
         return 1 << _metadata.capacity_exponent;
     };
+    size_type shrink_to_fit(zone *zone);
 
     // Modifiers
 
@@ -191,6 +192,30 @@ template <typename T> vector<T>::iterator vector<T>::erase(iterator first, itera
     return end();
 }
 
+// Returns the unused capacity to the zone. Returns the number of bytes released.
+template <typename T> vector<T>::size_type vector<T>::shrink_to_fit(zone *zone) {
+    if (_metadata.capacity_exponent <= 1) {
+        return 0;
+    }
+
+    size_type new_capacity_exponent = 1;
+    if (_metadata.size >= 2) {
+        new_capacity_exponent =
+            std::numeric_limits<size_type>::digits - std::countl_zero(size_type(_metadata.size - 1));
+    }
+    if (new_capacity_exponent >= _metadata.capacity_exponent) {
+        return 0;
+    }
+
+    size_type alignment_mask = std::has_unique_object_representations_v<T> ? alignof(T) - 1 : 0;
+    size_type released = zone->shrink_bytes((ptr<void> *)&_data, sizeof(T) * capacity(),
+                                            (size_type)sizeof(T) << new_capacity_exponent, alignment_mask);
+    if (released > 0) {
+        _metadata.capacity_exponent = new_capacity_exponent;
+    }
+    return released;
+}
+
 template <typename T> void vector<T>::push_back(zone *zone, const T &value) {
     reserve(zone, _metadata.size + 1);
     new (&data()[_metadata.size]) value_type(value);
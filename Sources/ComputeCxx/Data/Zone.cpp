@@ -1,5 +1,6 @@
 #include "Zone.h"
 
+#include <algorithm>
 #include <cstring>
 #include <stdio.h>
 
@@ -16,6 +17,15 @@ zone::zone() : _info(info(table::shared().make_zone_id())) {}
 
 zone::~zone() { clear(); }
 
+void zone::mark_deleted() {
+    _info = _info.with_deleted();
+
+    // weak attributes read the seed from the table instead of the zone
+    for (auto page : pages()) {
+        table::shared().set_page_seed(page, page_seed());
+    }
+}
+
 void zone::clear() {
     table::shared().lock();
     while (_first_page) {
@@ -24,6 +34,41 @@ void zone::clear() {
         table::shared().dealloc_page_locked(page);
     }
     table::shared().unlock();
+
+    for (auto &size_class_bytes : _free_bytes) {
+        size_class_bytes = nullptr;
+    }
+    _free_size_classes = 0;
+    _buffer_pages.remove_if([](ptr<page> buffer_page, ptr<page> previous_page) { return true; });
+}
+
+bool zone::is_buffer_page(ptr<page> page) const {
+    ptr<struct page> found_page;
+    _buffer_pages.lookup(page, &found_page);
+    return found_page != nullptr;
+}
+
+// Records the page before a buffer page in the page list, other pages don't need to be unlinked.
+void zone::set_previous_page(ptr<page> next_page, ptr<page> previous_page) {
+    if (next_page && is_buffer_page(next_page)) {
+        _buffer_pages.insert(next_page, previous_page);
+    }
+}
+
+void zone::release_buffer_page(ptr<page> buffer_page) {
+    ptr<page> previous_page = _buffer_pages.lookup(buffer_page, nullptr);
+    _buffer_pages.remove(buffer_page);
+
+    if (previous_page) {
+        previous_page->next = buffer_page->next;
+    } else {
+        _first_page = buffer_page->next;
+    }
+    set_previous_page(buffer_page->next, previous_page);
+
+    table::shared().lock();
+    table::shared().dealloc_page_locked(buffer_page);
+    table::shared().unlock();
 }
 
 void zone::realloc_bytes(ptr<void> *buffer, uint32_t size, uint32_t new_size, uint32_t alignment_mask) {
@@ -47,18 +92,55 @@ void zone::realloc_bytes(ptr<void> *buffer, uint32_t size, uint32_t new_size, ui
         memcpy(new_buffer.get(), (*buffer).get(), size);
 
         ptr<bytes_info> aligned_old_bytes = (*buffer).aligned<bytes_info>();
-        if ((*buffer).page_ptr() == aligned_old_bytes.page_ptr()) {
+        if (is_buffer_page(buffer->page_ptr())) {
+            release_buffer_page(buffer->page_ptr());
+        } else if ((*buffer).page_ptr() == aligned_old_bytes.page_ptr()) {
             uint32_t remaining_size = size - (aligned_old_bytes - *buffer);
             if (remaining_size >= sizeof(bytes_info)) {
-                aligned_old_bytes->next = _free_bytes;
-                aligned_old_bytes->size = remaining_size;
-                _free_bytes = aligned_old_bytes;
+                free_bytes(aligned_old_bytes, remaining_size);
             }
         }
     }
     *buffer = new_buffer;
 }
 
+// Releases the tail of a buffer, returning the number of bytes that can be reused. A buffer with pages of its own is
+// moved out, so that the pages go back to the table, otherwise the tail is released in place.
+uint32_t zone::shrink_bytes(ptr<void> *buffer_ptr, uint32_t size, uint32_t new_size, uint32_t alignment_mask) {
+    ptr<void> buffer = *buffer_ptr;
+    if (!buffer || new_size >= size) {
+        return 0;
+    }
+
+    if (is_buffer_page(buffer.page_ptr())) {
+        ptr<void> new_buffer = alloc_bytes_recycle(new_size, alignment_mask);
+        memcpy(new_buffer.get(), buffer.get(), new_size);
+        release_buffer_page(buffer.page_ptr());
+        *buffer_ptr = new_buffer;
+        return size - new_size;
+    }
+
+    auto page = buffer.page_ptr();
+    uint32_t buffer_offset_from_page = buffer.offset() - page.offset();
+    if (page == _first_page && page->in_use == buffer_offset_from_page + size) {
+        // the buffer is at the end of the bump allocated bytes, so just give them back
+        page->in_use -= size - new_size;
+        return size - new_size;
+    }
+
+    ptr<void> tail = buffer.advanced<void>(new_size);
+    ptr<bytes_info> aligned_tail = tail.aligned<bytes_info>();
+    if (tail.page_ptr() != aligned_tail.page_ptr() || (aligned_tail - buffer) >= size) {
+        return 0;
+    }
+    uint32_t remaining_size = size - (aligned_tail - buffer);
+    if (remaining_size < sizeof(bytes_info)) {
+        return 0;
+    }
+    free_bytes(aligned_tail, remaining_size);
+    return remaining_size;
+}
+
 ptr<void> zone::alloc_bytes(uint32_t size, uint32_t alignment_mask) {
     if (_first_page) {
         uint32_t aligned_in_use = (_first_page->in_use + alignment_mask) & ~alignment_mask;
@@ -75,48 +157,65 @@ ptr<void> zone::alloc_bytes(uint32_t size, uint32_t alignment_mask) {
     return alloc_slow(size, alignment_mask);
 }
 
-ptr<void> zone::alloc_bytes_recycle(uint32_t size, uint32_t alignment_mask) {
-    for (ptr<bytes_info> *indirect_bytes = &_free_bytes; *indirect_bytes; indirect_bytes = &(*indirect_bytes)->next) {
-        ptr<bytes_info> bytes = *indirect_bytes;
+void zone::free_bytes(ptr<bytes_info> bytes, uint32_t size) {
+    uint32_t bytes_size_class = size_class(size);
+    bytes->next = _free_bytes[bytes_size_class];
+    bytes->size = size;
+    _free_bytes[bytes_size_class] = bytes;
+    _free_size_classes |= 1 << bytes_size_class;
 
-        if (size > bytes->size) {
-            continue;
-        }
+    _recycle_stats.freed_count += 1;
+    _recycle_stats.freed_bytes += size;
+}
 
-        ptr<void> aligned_bytes = bytes.aligned<void>(alignment_mask);
-        auto unusable_size = aligned_bytes - bytes;
-        if (unusable_size >= bytes->size) {
-            continue;
-        }
-        uint32_t usable_size = bytes->size + (bytes - aligned_bytes);
-        if (size > usable_size) {
+ptr<void> zone::alloc_bytes_recycle(uint32_t size, uint32_t alignment_mask) {
+    // Blocks in the requested size class may still be too small, blocks in larger classes never are except for
+    // alignment padding, so the first usable block is taken.
+    for (uint32_t bytes_size_class = size_class(size); bytes_size_class < num_size_classes; ++bytes_size_class) {
+        if (!(_free_size_classes & (1 << bytes_size_class))) {
             continue;
         }
+        for (ptr<bytes_info> *indirect_bytes = &_free_bytes[bytes_size_class]; *indirect_bytes;
+             indirect_bytes = &(*indirect_bytes)->next) {
+            ptr<bytes_info> bytes = *indirect_bytes;
 
-        // Check the difference between needed and available bytes
-        // XXX: Dissassembly seems to rely on unsigned integer underflow here?
-        if (size - bytes->size > 0xff) {
-            continue;
-        }
+            if (size > bytes->size) {
+                continue;
+            }
 
-        // Remove this bytes out of recycle list
-        *indirect_bytes = bytes->next;
+            ptr<void> aligned_bytes = bytes.aligned<void>(alignment_mask);
+            auto unusable_size = aligned_bytes - bytes;
+            if (unusable_size >= bytes->size) {
+                continue;
+            }
+            uint32_t usable_size = bytes->size + (bytes - aligned_bytes);
+            if (size > usable_size) {
+                continue;
+            }
 
-        // check if there will be some bytes remaining within the same page
-        ptr<bytes_info> aligned_end = aligned_bytes.advanced<void>(size).aligned<bytes_info>();
-        if (aligned_bytes.page_ptr() == aligned_end.page_ptr()) {
-            uint32_t remaining_size = usable_size - (aligned_end - aligned_bytes);
-            if (remaining_size >= sizeof(bytes_info)) {
-                bytes_info *remaining_bytes = aligned_end.get();
-                remaining_bytes->next = _free_bytes;
-                remaining_bytes->size = remaining_size;
-                _free_bytes = aligned_end;
+            // Remove this bytes out of recycle list
+            *indirect_bytes = bytes->next;
+            if (!_free_bytes[bytes_size_class]) {
+                _free_size_classes &= ~(1 << bytes_size_class);
             }
-        }
 
-        return aligned_bytes;
+            _recycle_stats.recycled_count += 1;
+            _recycle_stats.recycled_bytes += size;
+
+            // check if there will be some bytes remaining within the same page
+            ptr<bytes_info> aligned_end = aligned_bytes.advanced<void>(size).aligned<bytes_info>();
+            if (aligned_bytes.page_ptr() == aligned_end.page_ptr()) {
+                uint32_t remaining_size = usable_size - (aligned_end - aligned_bytes);
+                if (remaining_size >= sizeof(bytes_info)) {
+                    free_bytes(aligned_end, remaining_size);
+                }
+            }
+
+            return aligned_bytes;
+        }
     }
 
+    _recycle_stats.missed_count += 1;
     return alloc_bytes(size, alignment_mask);
 }
 
@@ -130,10 +229,7 @@ ptr<void> zone::alloc_slow(uint32_t size, uint32_t alignment_mask) {
             if (aligned_next_bytes.page_ptr() == _first_page) {
                 uint32_t remaining_size = _first_page->total - _first_page->in_use - (aligned_next_bytes - next_bytes);
                 if (remaining_size >= sizeof(bytes_info)) {
-                    bytes_info *remaining_bytes = aligned_next_bytes.get();
-                    remaining_bytes->next = _free_bytes;
-                    remaining_bytes->size = remaining_size;
-                    _free_bytes = aligned_next_bytes;
+                    free_bytes(aligned_next_bytes, remaining_size);
                 }
             }
 
@@ -146,6 +242,7 @@ ptr<void> zone::alloc_slow(uint32_t size, uint32_t alignment_mask) {
     if (size <= page_size / 2) {
         new_page = table::shared().alloc_page(this, page_size);
         new_page->next = _first_page;
+        set_previous_page(_first_page, new_page);
         _first_page = new_page;
     } else {
         uint32_t aligned_size = ((sizeof(page) + alignment_mask) & ~alignment_mask) + size;
@@ -155,9 +252,11 @@ ptr<void> zone::alloc_slow(uint32_t size, uint32_t alignment_mask) {
             // so insert it after the first page.
             new_page->next = _first_page->next;
             _first_page->next = new_page;
+            set_previous_page(new_page->next, new_page);
         } else {
             _first_page = new_page;
         }
+        _buffer_pages.insert(new_page, _first_page != new_page ? _first_page : nullptr);
     }
 
     int32_t aligned_used_bytes = (new_page->in_use + alignment_mask) & ~alignment_mask;
@@ -168,6 +267,10 @@ ptr<void> zone::alloc_slow(uint32_t size, uint32_t alignment_mask) {
     }
 
     new_page->in_use = aligned_used_bytes + size;
+    if (size > page_size / 2) {
+        // keep the pages to this buffer, so they can be released when it moves
+        new_page->in_use = new_page->total;
+    }
     return new_page.advanced<void>(aligned_used_bytes);
 };
 
@@ -187,8 +290,8 @@ void *zone::alloc_persistent(size_t size) {
 #pragma mark - Printing
 
 void zone::print_header() {
-    fprintf(stdout, "Zones\n%-16s %6s %8s %8s    %6s %6s     %6s %8s\n", "zone ptr", "pages", "total", "in-use", "free",
-            "bytes", "malloc", "total");
+    fprintf(stdout, "Zones\n%-16s %6s %8s %8s    %6s %6s %8s     %6s %8s\n", "zone ptr", "pages", "total", "in-use",
+            "free", "bytes", "reused", "malloc", "total");
 }
 
 void zone::print() {
@@ -210,12 +313,13 @@ void zone::print() {
 
     unsigned long num_free_elements = 0;
     unsigned long free_bytes = 0;
-    if (_free_bytes) {
-        for (auto bytes = _free_bytes; bytes; bytes = bytes->next) {
+    for (auto size_class_bytes : _free_bytes) {
+        for (auto bytes = size_class_bytes; bytes; bytes = bytes->next) {
             num_free_elements++;
             free_bytes += bytes->size;
         }
     }
+    double recycled_kb = _recycle_stats.recycled_bytes / 1024.0;
 
     unsigned long num_persistent_buffers = _malloc_buffers.size();
     size_t malloc_total_size = 0;
@@ -224,13 +328,14 @@ void zone::print() {
     }
     double malloc_total_size_kb = malloc_total_size / 1024.0;
 
-    fprintf(stdout, "%-16p %6lu %8.2f %8.2f    %6lu %6lu     %6lu %8.2f\n",
+    fprintf(stdout, "%-16p %6lu %8.2f %8.2f    %6lu %6lu %8.2f     %6lu %8.2f\n",
             this,                   // zone ptr
             num_pages,              // pages
             pages_total_kb,         // total
             pages_in_use_kb,        // in-use
             num_free_elements,      // free
             free_bytes,             // bytes
+            recycled_kb,            // reused
             num_persistent_buffers, // malloc
             malloc_total_size_kb    // total
     );
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+
+#include <Utilities/FlatTable.h>
+
 #include "ComputeCxx/IAGBase.h"
 
 #include "Page.h"
@@ -47,11 +52,47 @@ class zone {
         uint32_t size;
     } bytes_info;
 
+    // Free bytes are segregated by power-of-two size class, starting at sizeof(bytes_info). The last class holds
+    // everything from 1KB up.
+    constexpr static uint32_t num_size_classes = 8;
+    static uint32_t size_class(uint32_t size) {
+        uint32_t width = std::bit_width(size);
+        return width <= 4 ? 0 : std::min(width - 4, num_size_classes - 1);
+    }
+
     vector<std::unique_ptr<void, table::malloc_zone_deleter>, 0, uint32_t> _malloc_buffers;
     ptr<page> _first_page;
-    ptr<bytes_info> _free_bytes;
+    ptr<bytes_info> _free_bytes[num_size_classes];
+    uint32_t _free_size_classes = 0; // bit per size class with a non-empty free list
+
+    struct page_hash {
+        uint64_t operator()(ptr<page> page) const noexcept { return util::mix_hash(page.offset()); }
+    };
+
+    // Pages allocated for a single buffer of more than half a page, mapped to the page before them in the page list,
+    // or null if they are first. Nothing else is placed in them, so they are unlinked and returned to the table as
+    // soon as the buffer moves out.
+    util::FlatTable<ptr<page>, ptr<page>, page_hash> _buffer_pages;
     info _info;
-    
+
+  public:
+    struct recycle_statistics {
+        uint64_t recycled_count;
+        uint64_t recycled_bytes;
+        uint64_t missed_count;
+        uint64_t freed_count;
+        uint64_t freed_bytes;
+    };
+
+  private:
+    recycle_statistics _recycle_stats = {};
+
+    void free_bytes(ptr<bytes_info> bytes, uint32_t size);
+
+    bool is_buffer_page(ptr<page> page) const;
+    void set_previous_page(ptr<page> next_page, ptr<page> previous_page);
+    void release_buffer_page(ptr<page> buffer_page);
+
     ptr<void> alloc_bytes(uint32_t size, uint32_t alignment_mask);
     ptr<void> alloc_bytes_recycle(uint32_t size, uint32_t alignment_mask);
     ptr<void> alloc_slow(uint32_t size, uint32_t alignment_mask);
@@ -61,17 +102,20 @@ class zone {
     ~zone();
 
     uint32_t zone_id() const { return _info.zone_id(); };
-    void mark_deleted() { _info = _info.with_deleted(); };
+    void mark_deleted();
     uint32_t page_seed() const { return _info.to_raw_value(); };
 
     page_ptr_list pages() const { return page_ptr_list(_first_page); };
 
     void clear();
+    const recycle_statistics &recycle_stats() const { return _recycle_stats; };
+
     void realloc_bytes(ptr<void> *buffer, uint32_t size, uint32_t new_size, uint32_t alignment_mask);
+    uint32_t shrink_bytes(ptr<void> *buffer, uint32_t size, uint32_t new_size, uint32_t alignment_mask);
 
     // Paged memory
     ptr<void> alloc(uint32_t size, uint32_t alignment_mask) {
-        if (size <= 0x10) {
+        if (_free_size_classes >> size_class(size)) {
             return alloc_bytes_recycle(size, alignment_mask);
         } else {
             return alloc_bytes(size, alignment_mask);
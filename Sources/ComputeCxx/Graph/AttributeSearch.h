@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "Attribute/AttributeID/AttributeID.h"
+#include "ComputeCxx/IAGBase.h"
+#include "Data/Constants.h"
+#include "Vector/Vector.h"
+
+IAG_ASSUME_NONNULL_BEGIN
+
+namespace IAG {
+
+/// A set of attributes with one bit per four bytes of the data table, allocated in chunks covering 512 pages as
+/// attributes in them are inserted. Attributes are identified by their offset, since a node and an indirect node
+/// can't share one.
+class AttributeBitmap {
+  private:
+    static constexpr uint32_t bits_per_chunk = 512 * data::page_size / 4;
+    static constexpr uint32_t words_per_chunk = bits_per_chunk / 64;
+
+    vector<uint64_t *_Nullable, 0, uint32_t> _chunks;
+
+    // attributes without an offset, i.e. the nil attribute, keyed by kind
+    uint8_t _null_kinds = 0;
+
+  public:
+    AttributeBitmap() = default;
+    ~AttributeBitmap() {
+        for (auto chunk : _chunks) {
+            free(chunk);
+        }
+    };
+
+    // non-copyable
+    AttributeBitmap(const AttributeBitmap &) = delete;
+    AttributeBitmap &operator=(const AttributeBitmap &) = delete;
+
+    // non-movable
+    AttributeBitmap(AttributeBitmap &&) = delete;
+    AttributeBitmap &operator=(AttributeBitmap &&) = delete;
+
+    /// Returns true if the attribute wasn't already in the set.
+    bool insert(AttributeID attribute) {
+        uint32_t index = IAGAttribute(attribute) >> 2;
+        if (index == 0) {
+            uint8_t kind_bit = 1 << (IAGAttribute(attribute) & AttributeID::KindMask);
+            bool inserted = (_null_kinds & kind_bit) == 0;
+            _null_kinds |= kind_bit;
+            return inserted;
+        }
+
+        uint32_t chunk_index = index / bits_per_chunk;
+        if (chunk_index >= _chunks.size()) {
+            _chunks.resize(chunk_index + 1, nullptr);
+        }
+        uint64_t *chunk = _chunks[chunk_index];
+        if (!chunk) {
+            chunk = static_cast<uint64_t *>(calloc(words_per_chunk, sizeof(uint64_t)));
+            _chunks[chunk_index] = chunk;
+        }
+
+        uint32_t bit_index = index % bits_per_chunk;
+        uint64_t mask = uint64_t(1) << (bit_index % 64);
+        uint64_t &word = chunk[bit_index / 64];
+        bool inserted = (word & mask) == 0;
+        word |= mask;
+        return inserted;
+    };
+};
+
+/// A FIFO queue of attributes in a ring buffer, which starts out inline and doubles when full.
+class AttributeQueue {
+  private:
+    static constexpr uint32_t inline_capacity = 64;
+
+    AttributeID _inline_buffer[inline_capacity];
+    AttributeID *_buffer = _inline_buffer;
+    uint32_t _capacity = inline_capacity; // always a power of two
+    uint32_t _head = 0;
+    uint32_t _count = 0;
+
+    void grow() {
+        uint32_t new_capacity = _capacity * 2;
+        auto new_buffer = static_cast<AttributeID *>(malloc(new_capacity * sizeof(AttributeID)));
+
+        // unwrap so the front of the queue is at the start of the new buffer
+        uint32_t head_count = _capacity - _head;
+        memcpy(new_buffer, _buffer + _head, head_count * sizeof(AttributeID));
+        memcpy(new_buffer + head_count, _buffer, _head * sizeof(AttributeID));
+
+        if (_buffer != _inline_buffer) {
+            free(_buffer);
+        }
+        _buffer = new_buffer;
+        _capacity = new_capacity;
+        _head = 0;
+    };
+
+  public:
+    AttributeQueue() = default;
+    ~AttributeQueue() {
+        if (_buffer != _inline_buffer) {
+            free(_buffer);
+        }
+    };
+
+    // non-copyable
+    AttributeQueue(const AttributeQueue &) = delete;
+    AttributeQueue &operator=(const AttributeQueue &) = delete;
+
+    // non-movable
+    AttributeQueue(AttributeQueue &&) = delete;
+    AttributeQueue &operator=(AttributeQueue &&) = delete;
+
+    bool empty() const { return _count == 0; };
+
+    void push_back(AttributeID attribute) {
+        if (_count == _capacity) {
+            grow();
+        }
+        _buffer[(_head + _count) & (_capacity - 1)] = attribute;
+        _count += 1;
+    };
+
+    AttributeID pop_front() {
+        assert(_count > 0);
+        AttributeID attribute = _buffer[_head];
+        _head = (_head + 1) & (_capacity - 1);
+        _count -= 1;
+        return attribute;
+    };
+};
+
+} // namespace IAG
+
+IAG_ASSUME_NONNULL_END
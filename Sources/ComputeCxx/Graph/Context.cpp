@@ -12,11 +12,11 @@ namespace IAG {
 Graph::Context::Context(Graph *graph) : _graph(graph), _id(IAGMakeUniqueID()) {
     Graph::retain(graph);
     graph->_contexts_by_id.insert(_id, this);
-    graph->foreach_trace([this](Trace &trace) { trace.created(*this); });
+    graph->foreach_trace(TraceEvents::Context, [this](Trace &trace) { trace.created(*this); });
 }
 
 Graph::Context::~Context() {
-    _graph->foreach_trace([this](Trace &trace) { trace.destroy(*this); });
+    _graph->foreach_trace(TraceEvents::Context, [this](Trace &trace) { trace.destroy(*this); });
 
     bool removed = _graph->_contexts_by_id.remove(_id);
     if (removed && _deadline != UINT64_MAX) {
@@ -56,7 +56,7 @@ void Graph::Context::set_deadline(uint64_t deadline) {
     }
 
     _deadline = deadline;
-    _graph->foreach_trace([this, &deadline](Trace &trace) { trace.set_deadline(deadline); });
+    _graph->foreach_trace(TraceEvents::Deadline, [this, &deadline](Trace &trace) { trace.set_deadline(deadline); });
 
     uint64_t min_deadline = UINT64_MAX;
     _graph->_contexts_by_id.for_each(
@@ -73,7 +73,7 @@ void Graph::Context::set_needs_update() {
     if (_needs_update) {
         return;
     }
-    _graph->foreach_trace([this](Trace &trace) { trace.needs_update(*this); });
+    _graph->foreach_trace(TraceEvents::NeedsUpdate, [this](Trace &trace) { trace.needs_update(*this); });
     _needs_update = true;
     _graph->set_needs_update(true);
 }
@@ -96,9 +96,13 @@ void Graph::Context::call_invalidation(AttributeID attribute) {
             set_current_update(old_update.with_tag(true));
         }
 
-        _graph->foreach_trace([this, &attribute](Trace &trace) { trace.begin_invalidation(*this, attribute); });
+        _graph->foreach_trace(TraceEvents::Invalidation, [this, &attribute](Trace &trace) {
+            trace.begin_invalidation(*this, attribute);
+        });
         _invalidation_callback(attribute);
-        _graph->foreach_trace([this, &attribute](Trace &trace) { trace.end_invalidation(*this, attribute); });
+        _graph->foreach_trace(TraceEvents::Invalidation, [this, &attribute](Trace &trace) {
+            trace.end_invalidation(*this, attribute);
+        });
 
         set_current_update(old_update);
     }
@@ -115,9 +119,9 @@ void Graph::Context::call_update() {
             UpdateStack(_graph, IAGGraphUpdateOptions(IAGGraphUpdateOptionsInitializeCleared |
                                                      IAGGraphUpdateOptionsEndDeferringSubgraphInvalidationOnExit));
 
-        _graph->foreach_trace([this](Trace &trace) { trace.begin_update(*this); });
+        _graph->foreach_trace(TraceEvents::ContextUpdate, [this](Trace &trace) { trace.begin_update(*this); });
         _update_callback();
-        _graph->foreach_trace([this](Trace &trace) { trace.end_update(*this); });
+        _graph->foreach_trace(TraceEvents::ContextUpdate, [this](Trace &trace) { trace.end_update(*this); });
 
         // ~UpdateStack()
     }
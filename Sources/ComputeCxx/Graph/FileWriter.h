@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "ComputeCxx/IAGBase.h"
+
+#if TARGET_OS_MAC
+#include <CoreFoundation/CFString.h>
+#else
+#include <SwiftCorelibsCoreFoundation/CFString.h>
+#endif
+
+IAG_ASSUME_NONNULL_BEGIN
+
+namespace IAG {
+
+/// Buffers output to a file descriptor, so that descriptions and snapshots can be written in small pieces without
+/// building them in memory first.
+class FileWriter {
+  private:
+    static constexpr size_t buffer_size = 16 * 1024;
+
+    int _fd;
+    size_t _length = 0;
+    bool _failed = false;
+    char _buffer[buffer_size];
+
+  public:
+    explicit FileWriter(int fd) : _fd(fd) {};
+    ~FileWriter() { flush(); };
+
+    // non-copyable
+    FileWriter(const FileWriter &) = delete;
+    FileWriter &operator=(const FileWriter &) = delete;
+
+    bool failed() const { return _failed; };
+
+    void flush() {
+        const char *remaining = _buffer;
+        while (_length > 0 && !_failed) {
+            ssize_t written = ::write(_fd, remaining, _length);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                _failed = true;
+                break;
+            }
+            remaining += written;
+            _length -= written;
+        }
+        _length = 0;
+    };
+
+    void write(const char *bytes, size_t length) {
+        while (length > 0) {
+            if (_length == buffer_size) {
+                flush();
+            }
+            size_t chunk_length = std::min(length, buffer_size - _length);
+            memcpy(_buffer + _length, bytes, chunk_length);
+            _length += chunk_length;
+            bytes += chunk_length;
+            length -= chunk_length;
+        }
+    };
+
+    void write(const char *string) { write(string, strlen(string)); };
+
+    template <typename Record> void write_record(const Record &record) {
+        write(reinterpret_cast<const char *>(&record), sizeof(Record));
+    };
+
+    void write_zeros(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            write('\0');
+        }
+    };
+
+    void write(char c) {
+        if (_length == buffer_size) {
+            flush();
+        }
+        _buffer[_length++] = c;
+    };
+
+    void write_uint(uint64_t value) {
+        char digits[20];
+        size_t count = 0;
+        do {
+            digits[count++] = char('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (count > 0) {
+            write(digits[--count]);
+        }
+    };
+
+    void write_format(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        char string[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(string, sizeof(string), format, args);
+        va_end(args);
+        if (length > 0) {
+            write(string, std::min(size_t(length), sizeof(string) - 1));
+        }
+    };
+
+    /// Writes at most truncation_limit characters of a UTF-8 string followed by an ellipsis if it was truncated,
+    /// escaping characters for a JSON string or a DOT label.
+    void write_escaped(const char *string, size_t truncation_limit, bool json) {
+        size_t num_characters = 0;
+        for (const char *c = string; *c; ++c) {
+            bool is_continuation = (uint8_t(*c) & 0xc0) == 0x80;
+            if (!is_continuation) {
+                if (num_characters == truncation_limit) {
+                    write("…");
+                    return;
+                }
+                num_characters += 1;
+            }
+
+            if (*c == '"') {
+                write("\\\"");
+            } else if (json && *c == '\\') {
+                write("\\\\");
+            } else if (json && uint8_t(*c) < 0x20) {
+                write_format("\\u%04x", uint8_t(*c));
+            } else {
+                write(*c);
+            }
+        }
+    };
+
+    void write_escaped(CFStringRef string, size_t truncation_limit, bool json) {
+        if (const char *c_string = CFStringGetCStringPtr(string, kCFStringEncodingUTF8)) {
+            write_escaped(c_string, truncation_limit, json);
+            return;
+        }
+
+        CFIndex length = CFStringGetLength(string);
+        CFIndex buffer_size = CFStringGetMaximumSizeForEncoding(length, kCFStringEncodingUTF8) + 1;
+        char *buffer = (char *)malloc(buffer_size);
+        if (CFStringGetCString(string, buffer, buffer_size, kCFStringEncodingUTF8)) {
+            write_escaped(buffer, truncation_limit, json);
+        }
+        free(buffer);
+    };
+};
+
+} // namespace IAG
+
+IAG_ASSUME_NONNULL_END
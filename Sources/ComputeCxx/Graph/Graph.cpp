@@ -5,9 +5,8 @@
 #else
 #include <SwiftCorelibsCoreFoundation/CFString.h>
 #endif
-#include <deque>
+#include <algorithm>
 #include <ranges>
-#include <set>
 
 #include <Utilities/FreeDeleter.h>
 #include <Utilities/List.h>
@@ -20,12 +19,15 @@
 #include "Attribute/AttributeID/OffsetAttributeID.h"
 #include "Attribute/AttributeType/AttributeType.h"
 #include "Attribute/AttributeView/AttributeView.h"
+#include "AttributeSearch.h"
 #include "ComputeCxx/IAGGraphTracing.h"
 #include "ComputeCxx/IAGUniqueID.h"
 #include "Context.h"
 #include "KeyTable.h"
 #include "Log/Log.h"
+#include "ProfileData.h"
 #include "Protobuf/Encoder.h"
+#include "Subgraph/NodeCache.h"
 #include "Subgraph/Subgraph.h"
 #include "TraceRecorder.h"
 #include "UpdateStack.h"
@@ -41,6 +43,23 @@ Graph::Graph()
     : _heap(nullptr, 0, 0), _interned_types(nullptr, nullptr, nullptr, nullptr, &_heap),
       _contexts_by_id(nullptr, nullptr, nullptr, nullptr, &_heap), _id(IAGMakeUniqueID()) {
 
+    static uint64_t node_cache_budget = []() -> uint64_t {
+        const char *budget = getenv("IAG_NODE_CACHE_BUDGET");
+        if (budget) {
+            return strtoull(budget, nullptr, 0);
+        }
+        return 0;
+    }();
+    _node_cache_budget = node_cache_budget;
+
+    static bool profile = []() -> bool {
+        const char *profile = getenv("IAG_PROFILE");
+        return profile && atoi(profile) != 0;
+    }();
+    if (profile) {
+        start_profiling();
+    }
+
     static platform_once_t make_keys;
     platform_once(&make_keys, []() {
         pthread_key_create(&Graph::_current_update_key, 0);
@@ -89,6 +108,12 @@ Graph::Graph()
                     } else if (strcasecmp(option, "all") == 0) {
                         trace_flags |= IAGGraphTraceFlagsAll;
                         free(option);
+                    } else if (strcasecmp(option, "compact") == 0) {
+                        trace_flags |= IAGGraphTraceFlagsCompact;
+                        free(option);
+                    } else if (strcasecmp(option, "compressed") == 0) {
+                        trace_flags |= IAGGraphTraceFlagsCompressed;
+                        free(option);
                     } else {
                         trace_subsystems.push_back(std::unique_ptr<const char, util::free_deleter>(option));
                     }
@@ -143,6 +168,9 @@ Graph::~Graph() {
     if (_keys) {
         delete _keys;
     }
+    if (_profile_data) {
+        delete _profile_data;
+    }
 }
 
 #pragma mark - Context
@@ -245,6 +273,15 @@ void Graph::remove_subgraph(Subgraph &subgraph) {
         }
     }
 
+    if (auto tree_element = subgraph.tree_root()) {
+        while (tree_element->parent) {
+            tree_element = tree_element->parent;
+        }
+        set_tree_owner(&subgraph, tree_element->value, AttributeID());
+    }
+
+    subgraph.cache_unlink_idle_items();
+
     if (subgraph.has_cached_nodes()) {
         subgraph.set_has_cached_nodes(false);
         auto iter = std::remove(_subgraphs_with_cached_nodes.begin(), _subgraphs_with_cached_nodes.end(), &subgraph);
@@ -271,6 +308,8 @@ void Graph::invalidate_subgraphs() {
     }
 
     if (_main_handler == nullptr) {
+        evict_node_cache_entries();
+
         auto iter = _subgraphs_with_cached_nodes.begin(), end = _subgraphs_with_cached_nodes.end();
         while (iter != end) {
             auto subgraph = *iter;
@@ -293,6 +332,69 @@ void Graph::invalidate_subgraphs() {
     }
 }
 
+uint64_t Graph::num_recycled_allocations() const {
+    uint64_t count = 0;
+    for (auto subgraph : _subgraphs) {
+        count += subgraph->recycle_stats().recycled_count;
+    }
+    return count;
+}
+
+uint64_t Graph::num_recycled_bytes() const {
+    uint64_t bytes = 0;
+    for (auto subgraph : _subgraphs) {
+        bytes += subgraph->recycle_stats().recycled_bytes;
+    }
+    return bytes;
+}
+
+#pragma mark - Node cache
+
+// Idle cache items of every subgraph are linked from least to most recently used, so that once the values they hold
+// exceed the budget, the oldest can be evicted regardless of their type or subgraph.
+
+void Graph::node_cache_link(NodeCacheEntry &entry, uint64_t size) {
+    entry.lru_prev = _node_cache_mru;
+    entry.lru_next = nullptr;
+    entry.lru_size = size;
+    if (_node_cache_mru) {
+        _node_cache_mru->lru_next = &entry;
+    } else {
+        _node_cache_lru = &entry;
+    }
+    _node_cache_mru = &entry;
+    _node_cache_bytes += size;
+}
+
+void Graph::node_cache_unlink(NodeCacheEntry &entry) {
+    if (entry.lru_prev) {
+        entry.lru_prev->lru_next = entry.lru_next;
+    } else {
+        _node_cache_lru = entry.lru_next;
+    }
+    if (entry.lru_next) {
+        entry.lru_next->lru_prev = entry.lru_prev;
+    } else {
+        _node_cache_mru = entry.lru_prev;
+    }
+    entry.lru_prev = nullptr;
+    entry.lru_next = nullptr;
+    _node_cache_bytes -= entry.lru_size;
+    entry.lru_size = 0;
+}
+
+void Graph::evict_node_cache_entries() {
+    if (_node_cache_budget == 0) {
+        return;
+    }
+
+    while (_node_cache_bytes > _node_cache_budget && _node_cache_lru) {
+        auto item = static_cast<Subgraph::NodeCache::Item *>(_node_cache_lru);
+        AttributeID(item->node).subgraph()->cache_evict(*item);
+        _node_cache_evictions += 1;
+    }
+}
+
 #pragma mark - Attribute type
 
 const AttributeType &Graph::attribute_ref(data::ptr<Node> attribute, const void *_Nullable *_Nullable ref_out) const {
@@ -476,29 +578,32 @@ data::ptr<IndirectNode> Graph::add_indirect_attribute(Subgraph &subgraph, Attrib
     }
 }
 
-void Graph::remove_node(data::ptr<Node> node) {
+void Graph::remove_node(data::ptr<Node> node, vector<AttributeID, 0, uint64_t> &surviving_inputs) {
     if (node->is_updating()) {
         precondition_failure("deleting updating attribute: %u\n", node);
     }
+    discard_output_edge_index(AttributeID(node));
 
     for (auto &input_edge : node->input_edges()) {
-        this->remove_removed_input(AttributeID(node), input_edge.attribute);
+        this->remove_removed_input(AttributeID(node), input_edge.attribute, &surviving_inputs);
     }
     for (auto output_edge : node->output_edges()) {
         this->remove_removed_output(AttributeID(node), output_edge.attribute, false);
     }
 
-    //    if (_profile_data != nullptr) {
-    //        _profile_data->remove_node(node, node->type_id());
-    //    }
+    if (_profile_data != nullptr) {
+        _profile_data->remove_node(node, node->type_id());
+    }
 }
 
-void Graph::remove_indirect_node(data::ptr<IndirectNode> indirect_node) {
+void Graph::remove_indirect_node(data::ptr<IndirectNode> indirect_node,
+                                 vector<AttributeID, 0, uint64_t> &surviving_inputs) {
     if (indirect_node->is_mutable()) {
-        remove_removed_input(AttributeID(indirect_node), indirect_node->source().identifier());
+        discard_output_edge_index(AttributeID(indirect_node));
+        remove_removed_input(AttributeID(indirect_node), indirect_node->source().identifier(), &surviving_inputs);
         AttributeID dependency = indirect_node->to_mutable().dependency();
         if (dependency) {
-            remove_removed_input(AttributeID(indirect_node), dependency);
+            remove_removed_input(AttributeID(indirect_node), dependency, &surviving_inputs);
         }
         for (auto output_edge : indirect_node->to_mutable().output_edges()) {
             remove_removed_output(AttributeID(indirect_node), output_edge.attribute, false);
@@ -552,20 +657,59 @@ void Graph::remove_indirect_node(data::ptr<IndirectNode> indirect_node) {
     }
 }
 
-void Graph::remove_removed_input(AttributeID attribute, AttributeID input) {
+void Graph::remove_removed_input(AttributeID attribute, AttributeID input,
+                                 vector<AttributeID, 0, uint64_t> *_Nullable surviving_inputs) {
     auto resolved_input =
         input.resolve(TraversalOptions::SkipMutableReference | TraversalOptions::EvaluateWeakReferences).attribute();
     if (auto input_node = resolved_input.get_node()) {
         if (!resolved_input.subgraph()->is_invalidated()) {
-            remove_output_edge(input_node, attribute);
+            if (surviving_inputs) {
+                surviving_inputs->push_back(resolved_input);
+            } else {
+                remove_output_edge(input_node, attribute);
+            }
         }
     } else if (auto input_indirect_node = resolved_input.get_indirect_node()) {
         if (!resolved_input.subgraph()->is_invalidated()) {
             if (input_indirect_node->is_mutable()) {
-                remove_output_edge(input_indirect_node.unsafe_cast<MutableIndirectNode>(), attribute);
+                if (surviving_inputs) {
+                    surviving_inputs->push_back(resolved_input);
+                } else {
+                    remove_output_edge(input_indirect_node.unsafe_cast<MutableIndirectNode>(), attribute);
+                }
+            }
+        }
+    }
+}
+
+void Graph::remove_removed_outputs(vector<AttributeID, 0, uint64_t> &surviving_inputs) {
+    // An input shared by many removed nodes is only visited once, and each of its output edges is checked once,
+    // instead of searching and erasing its output edges for every removed node.
+    std::sort(surviving_inputs.begin(), surviving_inputs.end());
+    auto last = std::unique(surviving_inputs.begin(), surviving_inputs.end());
+
+    auto is_removed = [](const OutputEdge &output_edge) -> bool {
+        return output_edge.attribute.subgraph()->is_invalidated();
+    };
+
+    for (auto iter = surviving_inputs.begin(); iter != last; ++iter) {
+        AttributeID input = *iter;
+        discard_output_edge_index(input);
+        if (auto input_node = input.get_node()) {
+            auto &output_edges = input_node->output_edges();
+            output_edges.erase(std::remove_if(output_edges.begin(), output_edges.end(), is_removed),
+                               output_edges.end());
+            if (output_edges.empty() && input_node->is_cached()) {
+                input.subgraph()->cache_insert(input_node);
             }
+        } else if (auto input_indirect_node = input.get_indirect_node()) {
+            auto &output_edges = input_indirect_node->to_mutable().output_edges();
+            output_edges.erase(std::remove_if(output_edges.begin(), output_edges.end(), is_removed),
+                               output_edges.end());
         }
     }
+
+    surviving_inputs.clear();
 }
 
 bool Graph::remove_removed_output(AttributeID attribute, AttributeID output, bool option) {
@@ -592,10 +736,11 @@ bool Graph::remove_removed_output(AttributeID attribute, AttributeID output, boo
             assert(output_indirect_node->is_mutable());
             auto dependency = output_indirect_node->to_mutable().dependency();
             if (dependency && dependency == attribute) {
-                foreach_trace([&output_indirect_node](Trace &trace) {
+                foreach_trace(TraceEvents::IndirectNode, [&output_indirect_node](Trace &trace) {
                     trace.set_dependency(output_indirect_node, AttributeID(IAGAttributeNil));
                 });
                 output_indirect_node->to_mutable().set_dependency(AttributeID(nullptr));
+                invalidate_indirect_resolutions();
                 return true;
             }
 
@@ -614,11 +759,12 @@ bool Graph::remove_removed_output(AttributeID attribute, AttributeID output, boo
             }
         }
 
-        foreach_trace([&output_indirect_node, &new_source](Trace &trace) {
+        foreach_trace(TraceEvents::IndirectNode, [&output_indirect_node, &new_source](Trace &trace) {
             trace.set_source(output_indirect_node, new_source.identifier());
         });
 
         output_indirect_node->modify(new_source, new_offset);
+        invalidate_indirect_resolutions();
 
         if (new_source.identifier() && !new_source.identifier().is_nil() && !new_source.expired()) {
             add_input_dependencies(output, new_source.identifier());
@@ -642,7 +788,7 @@ uint32_t Graph::add_input(data::ptr<Node> node, AttributeID input, bool allow_ni
         precondition_failure("cyclic edge: %u -> %u", resolved_input, node);
     }
 
-    foreach_trace([&node, &input, &options](Trace &trace) { trace.add_edge(node, input, options); });
+    foreach_trace(TraceEvents::Edge, [&node, &input, &options](Trace &trace) { trace.add_edge(node, input, options); });
 
     auto subgraph = AttributeID(node).subgraph();
     auto context_id = subgraph ? subgraph->context_id() : 0;
@@ -667,7 +813,9 @@ uint32_t Graph::add_input(data::ptr<Node> node, AttributeID input, bool allow_ni
         reset_update(node);
     }
     if (node->is_dirty()) {
-        foreach_trace([&node, &input_index](Trace &trace) { trace.set_edge_pending(node, input_index, true); });
+        foreach_trace(TraceEvents::EdgePending, [&node, &input_index](Trace &trace) {
+            trace.set_edge_pending(node, input_index, true);
+        });
     }
 
     return input_index;
@@ -679,7 +827,7 @@ void Graph::remove_input(data::ptr<Node> node, uint32_t index) {
 }
 
 void Graph::remove_input_edge(data::ptr<Node> node_ptr, Node &node, uint32_t index) {
-    foreach_trace([&node_ptr, &index](Trace &trace) { trace.remove_edge(node_ptr, index); });
+    foreach_trace(TraceEvents::Edge, [&node_ptr, &index](Trace &trace) { trace.remove_edge(node_ptr, index); });
 
     node.remove_input_edge(index);
     if (node.input_edges().size() == 0) {
@@ -706,19 +854,15 @@ void Graph::all_inputs_removed(data::ptr<Node> node) {
 }
 
 template <> void Graph::add_output_edge<Node>(data::ptr<Node> node, AttributeID output) {
-    node->output_edges().push_back(node.page_ptr()->zone, OutputEdge(output));
+    insert_output_edge(AttributeID(node), node->output_edges(), node.page_ptr()->zone, output);
 }
 
 template <> void Graph::add_output_edge<MutableIndirectNode>(data::ptr<MutableIndirectNode> node, AttributeID output) {
-    node->output_edges().push_back(node.page_ptr()->zone, OutputEdge(output));
+    insert_output_edge(AttributeID(node), node->output_edges(), node.page_ptr()->zone, output);
 }
 
 template <> void Graph::remove_output_edge<Node>(data::ptr<Node> node, AttributeID output) {
-    auto iter = std::find_if(node->output_edges().begin(), node->output_edges().end(),
-                             [&output](auto iter) -> bool { return iter.attribute == output; });
-    if (iter != node->output_edges().end()) {
-        node->output_edges().erase(iter);
-    }
+    erase_output_edge(AttributeID(node), node->output_edges(), output);
 
     if (node->output_edges().empty() && node->is_cached()) {
         AttributeID(node).subgraph()->cache_insert(node);
@@ -727,10 +871,65 @@ template <> void Graph::remove_output_edge<Node>(data::ptr<Node> node, Attribute
 
 template <>
 void Graph::remove_output_edge<MutableIndirectNode>(data::ptr<MutableIndirectNode> node, AttributeID output) {
-    auto iter = std::find_if(node->output_edges().begin(), node->output_edges().end(),
-                             [&output](auto iter) -> bool { return iter.attribute == output; });
-    if (iter != node->output_edges().end()) {
-        node->output_edges().erase(iter);
+    erase_output_edge(AttributeID(node), node->output_edges(), output);
+}
+
+void Graph::insert_output_edge(AttributeID attribute, data::vector<OutputEdge> &output_edges, data::zone *zone,
+                               AttributeID output) {
+    output_edges.push_back(zone, OutputEdge(output));
+    if (output_edges.size() < output_edge_index_threshold) {
+        return;
+    }
+
+    auto [iter, inserted] = _output_edge_indices.try_emplace(attribute);
+    OutputEdgeIndex &index = iter->second;
+    if (inserted) {
+        // build the index once the attribute crosses the threshold
+        index.reserve(output_edges.size() * 2);
+        for (uint32_t position = 0, size = output_edges.size(); position < size; ++position) {
+            index.emplace(output_edges[position].attribute, position);
+        }
+    } else {
+        index.emplace(output, output_edges.size() - 1);
+    }
+}
+
+void Graph::erase_output_edge(AttributeID attribute, data::vector<OutputEdge> &output_edges, AttributeID output) {
+    auto index_iter = output_edges.size() >= output_edge_index_threshold / 2 ? _output_edge_indices.find(attribute)
+                                                                            : _output_edge_indices.end();
+    if (index_iter == _output_edge_indices.end()) {
+        auto iter = std::find_if(output_edges.begin(), output_edges.end(),
+                                 [&output](auto iter) -> bool { return iter.attribute == output; });
+        if (iter != output_edges.end()) {
+            output_edges.erase(iter);
+        }
+        return;
+    }
+
+    OutputEdgeIndex &index = index_iter->second;
+    auto position_iter = index.find(output);
+    if (position_iter == index.end()) {
+        return;
+    }
+
+    // Move the last edge into the removed edge's position instead of shifting the remaining edges
+    uint32_t position = position_iter->second;
+    uint32_t last_position = output_edges.size() - 1;
+    index.erase(position_iter);
+    if (position != last_position) {
+        output_edges[position] = output_edges[last_position];
+        auto [begin, end] = index.equal_range(output_edges[position].attribute);
+        for (auto iter = begin; iter != end; ++iter) {
+            if (iter->second == last_position) {
+                iter->second = position;
+                break;
+            }
+        }
+    }
+    output_edges.erase(output_edges.end() - 1);
+
+    if (output_edges.size() < output_edge_index_threshold / 2) {
+        _output_edge_indices.erase(index_iter);
     }
 }
 
@@ -861,7 +1060,9 @@ void Graph::indirect_attribute_set(data::ptr<IndirectNode> indirect_node, Attrib
         precondition_failure("attribute references can't cross graph namespaces");
     }
 
-    foreach_trace([&indirect_node, &source](Trace &trace) { trace.set_source(indirect_node, source); });
+    foreach_trace(TraceEvents::IndirectNode, [&indirect_node, &source](Trace &trace) {
+        trace.set_source(indirect_node, source);
+    });
 
     OffsetAttributeID resolved_source = source.resolve(TraversalOptions::SkipMutableReference);
     source = resolved_source.attribute();
@@ -877,6 +1078,7 @@ void Graph::indirect_attribute_set(data::ptr<IndirectNode> indirect_node, Attrib
 
     uint64_t source_subgraph_id = source && !source.is_nil() ? source.subgraph()->subgraph_id() : 0;
     indirect_node->modify(WeakAttributeID(source, uint32_t(source_subgraph_id)), resolved_source.offset());
+    invalidate_indirect_resolutions();
     indirect_node->set_traverses_contexts(AttributeID(indirect_node).subgraph()->context_id() !=
                                           source.subgraph()->context_id());
 
@@ -910,14 +1112,16 @@ bool Graph::indirect_attribute_reset(data::ptr<IndirectNode> indirect_node, bool
     AttributeID old_source_or_nil = indirect_node->source().evaluate();
     AttributeID new_source_or_nil = new_source.evaluate();
 
-    foreach_trace(
-        [&indirect_node, &new_source_or_nil](Trace &trace) { trace.set_source(indirect_node, new_source_or_nil); });
+    foreach_trace(TraceEvents::IndirectNode, [&indirect_node, &new_source_or_nil](Trace &trace) {
+        trace.set_source(indirect_node, new_source_or_nil);
+    });
 
     if (old_source_or_nil != new_source_or_nil) {
         remove_input_dependencies(AttributeID(indirect_node), old_source_or_nil);
     }
 
     indirect_node->modify(new_source, new_offset);
+    invalidate_indirect_resolutions();
     if (new_source_or_nil && !new_source_or_nil.is_nil()) {
         indirect_node->set_traverses_contexts(AttributeID(indirect_node).subgraph()->context_id() !=
                                               new_source_or_nil.subgraph()->context_id());
@@ -956,7 +1160,9 @@ void Graph::indirect_attribute_set_dependency(data::ptr<IndirectNode> indirect_n
         precondition_failure("not an indirect attribute: %u", indirect_node);
     }
 
-    foreach_trace([&indirect_node, &dependency](Trace &trace) { trace.set_dependency(indirect_node, dependency); });
+    foreach_trace(TraceEvents::IndirectNode, [&indirect_node, &dependency](Trace &trace) {
+        trace.set_dependency(indirect_node, dependency);
+    });
 
     AttributeID old_dependency = indirect_node->to_mutable().dependency();
     if (old_dependency != dependency) {
@@ -965,6 +1171,7 @@ void Graph::indirect_attribute_set_dependency(data::ptr<IndirectNode> indirect_n
             remove_output_edge(old_dependency.get_node(), indirect_attribute);
         }
         indirect_node->to_mutable().set_dependency(dependency);
+        invalidate_indirect_resolutions();
         if (dependency) {
             add_output_edge(dependency.get_node(), indirect_attribute);
             if (dependency.get_node()->is_dirty()) {
@@ -983,14 +1190,13 @@ bool Graph::breadth_first_search(AttributeID attribute, IAGSearchOptions options
         return false;
     }
 
-    auto seen = std::set<AttributeID>();
+    auto seen = AttributeBitmap();
 
-    auto queue = std::deque<AttributeID>();
+    auto queue = AttributeQueue();
     queue.push_back(resolved.attribute());
 
     while (!queue.empty()) {
-        AttributeID candidate = queue.front();
-        queue.pop_front();
+        AttributeID candidate = queue.pop_front();
 
         if (candidate.is_nil()) {
             continue;
@@ -1004,14 +1210,11 @@ bool Graph::breadth_first_search(AttributeID attribute, IAGSearchOptions options
             if (auto candidate_node = candidate.get_node()) {
                 for (auto input_edge : candidate_node->input_edges()) {
                     auto input = input_edge.attribute.resolve(TraversalOptions::SkipMutableReference).attribute();
-                    if (seen.contains(input)) {
-                        continue;
-                    }
-
                     if (options & IAGSearchOptionsTraverseGraphContexts ||
                         candidate.subgraph()->context_id() == input.subgraph()->context_id()) {
-                        seen.insert(input);
-                        queue.push_back(input);
+                        if (seen.insert(input)) {
+                            queue.push_back(input);
+                        }
                     }
                 }
             } else if (auto candidate_indirect_node = candidate.get_indirect_node()) {
@@ -1019,10 +1222,9 @@ bool Graph::breadth_first_search(AttributeID attribute, IAGSearchOptions options
                                          .identifier()
                                          .resolve(TraversalOptions::SkipMutableReference)
                                          .attribute();
-                if (!seen.contains(source)) {
-                    if (options & IAGSearchOptionsTraverseGraphContexts ||
-                        candidate.subgraph()->context_id() == source.subgraph()->context_id()) {
-                        seen.insert(source);
+                if (options & IAGSearchOptionsTraverseGraphContexts ||
+                    candidate.subgraph()->context_id() == source.subgraph()->context_id()) {
+                    if (seen.insert(source)) {
                         queue.push_back(source);
                     }
                 }
@@ -1033,27 +1235,21 @@ bool Graph::breadth_first_search(AttributeID attribute, IAGSearchOptions options
             // outputs should never be non-mutable nodes - check!
             if (auto candidate_node = candidate.get_node()) {
                 for (auto output_edge : candidate_node->output_edges()) {
-                    if (seen.contains(output_edge.attribute)) {
-                        continue;
-                    }
-
                     if (options & IAGSearchOptionsTraverseGraphContexts ||
                         candidate.subgraph()->context_id() == output_edge.attribute.subgraph()->context_id()) {
-                        seen.insert(output_edge.attribute);
-                        queue.push_back(output_edge.attribute);
+                        if (seen.insert(output_edge.attribute)) {
+                            queue.push_back(output_edge.attribute);
+                        }
                     }
                 }
             } else if (auto candidate_indirect_node = candidate.get_indirect_node()) {
                 assert(candidate_indirect_node->is_mutable());
                 for (auto output_edge : candidate_indirect_node->to_mutable().output_edges()) {
-                    if (seen.contains(output_edge.attribute)) {
-                        continue;
-                    }
-
                     if (options & IAGSearchOptionsTraverseGraphContexts ||
                         candidate.subgraph()->context_id() == output_edge.attribute.subgraph()->context_id()) {
-                        seen.insert(output_edge.attribute);
-                        queue.push_back(output_edge.attribute);
+                        if (seen.insert(output_edge.attribute)) {
+                            queue.push_back(output_edge.attribute);
+                        }
                     }
                 }
             }
@@ -1063,6 +1259,52 @@ bool Graph::breadth_first_search(AttributeID attribute, IAGSearchOptions options
     return false;
 }
 
+#pragma mark - Profile
+
+void Graph::start_profiling() {
+    if (_profile_data == nullptr) {
+        _profile_data = new ProfileData();
+    }
+    _is_profiling.store(true, std::memory_order_release);
+}
+
+void Graph::reset_profile() {
+    if (_profile_data) {
+        _profile_data->reset();
+    }
+}
+
+void Graph::record_profile_update(data::ptr<Node> node, uint64_t duration) {
+    if (_profile_data) {
+        uint32_t subgraph_id = uint32_t(AttributeID(node).subgraph()->subgraph_id());
+        _profile_data->record_update(node->type_id(), subgraph_id, duration);
+    }
+}
+
+void Graph::all_start_profiling() {
+    all_lock();
+    for (auto graph = _all_graphs; graph != nullptr; graph = graph->_next) {
+        graph->start_profiling();
+    }
+    all_unlock();
+}
+
+void Graph::all_stop_profiling() {
+    all_lock();
+    for (auto graph = _all_graphs; graph != nullptr; graph = graph->_next) {
+        graph->stop_profiling();
+    }
+    all_unlock();
+}
+
+void Graph::all_reset_profile() {
+    all_lock();
+    for (auto graph = _all_graphs; graph != nullptr; graph = graph->_next) {
+        graph->reset_profile();
+    }
+    all_unlock();
+}
+
 #pragma mark - Updates
 
 bool Graph::passed_deadline() {
@@ -1082,7 +1324,7 @@ bool Graph::passed_deadline_slow() {
         return false;
     }
 
-    foreach_trace([](Trace &trace) { trace.passed_deadline(); });
+    foreach_trace(TraceEvents::Deadline, [](Trace &trace) { trace.passed_deadline(); });
     _deadline = 0;
 
     return true;
@@ -1164,8 +1406,9 @@ Graph::UpdateStatus Graph::update_attribute(data::ptr<Node> node, IAGGraphUpdate
 
     UpdateStack current_update = UpdateStack(this, options);
 
-    foreach_trace(
-        [&current_update, &node, &options](Trace &trace) { trace.begin_update(current_update, node, options); });
+    foreach_trace(TraceEvents::NodeUpdate, [&current_update, &node, &options](Trace &trace) {
+        trace.begin_update(current_update, node, options);
+    });
 
     UpdateStatus status = UpdateStatus::Changed;
     if (current_update.push(node, *node.get(), false, !(options & IAGGraphUpdateOptionsInTransaction))) {
@@ -1184,7 +1427,7 @@ Graph::UpdateStatus Graph::update_attribute(data::ptr<Node> node, IAGGraphUpdate
         }
     }
 
-    foreach_trace([&current_update, &node, &status](Trace &trace) {
+    foreach_trace(TraceEvents::NodeUpdate, [&current_update, &node, &status](Trace &trace) {
         trace.end_update(current_update, node, IAGGraphUpdateStatus(status));
     });
 
@@ -1194,7 +1437,7 @@ Graph::UpdateStatus Graph::update_attribute(data::ptr<Node> node, IAGGraphUpdate
 
 void Graph::mark_changed(data::ptr<Node> node, AttributeType *_Nullable type, const void *_Nullable destination_value,
                          const void *_Nullable source_value) {
-    if (!_traces.empty()) {
+    if (has_trace_events(TraceEvents::EdgePending)) {
         mark_changed(AttributeID(node), type, destination_value, source_value, 0);
         return;
     }
@@ -1282,7 +1525,7 @@ void Graph::mark_changed(AttributeID attribute, AttributeType *_Nullable type, c
                             continue;
                         }
                     }
-                    foreach_trace([&output_node, &input_index](Trace &trace) {
+                    foreach_trace(TraceEvents::EdgePending, [&output_node, &input_index](Trace &trace) {
                         trace.set_edge_pending(output_node, input_index, true);
                     });
                     input_edge.options |= IAGInputOptionsChanged;
@@ -1341,9 +1584,10 @@ void Graph::compare_failed(const void *lhs, const void *rhs, size_t range_offset
 
     auto graph = update.get()->graph();
     auto attribute = update.get()->frames().back().attribute;
-    graph->foreach_trace([&attribute, &lhs, &rhs, &range_offset, &range_size](Trace &trace) {
-        trace.compare_failed(attribute, lhs, rhs, range_offset, range_size, nullptr);
-    });
+    graph->foreach_trace(
+        TraceEvents::CompareFailed, [&attribute, &lhs, &rhs, &range_offset, &range_size](Trace &trace) {
+            trace.compare_failed(attribute, lhs, rhs, range_offset, range_size, nullptr);
+        });
 }
 
 #pragma mark - Body
@@ -1359,12 +1603,12 @@ void Graph::attribute_modify(data::ptr<Node> node, const swift::metadata &metada
         precondition_failure("self type mismatch: %u", node);
     }
 
-    foreach_trace([&node](Trace &trace) { trace.begin_modify(node); });
+    foreach_trace(TraceEvents::Modify, [&node](Trace &trace) { trace.begin_modify(node); });
 
     void *body = node->get_self(type);
     modify(body);
 
-    foreach_trace([&node](Trace &trace) { trace.end_modify(node); });
+    foreach_trace(TraceEvents::Modify, [&node](Trace &trace) { trace.end_modify(node); });
 
     if (invalidating) {
         node->set_self_modified(true);
@@ -1374,11 +1618,11 @@ void Graph::attribute_modify(data::ptr<Node> node, const swift::metadata &metada
 
 void Graph::mark_pending(data::ptr<Node> node_ptr, Node *node) {
     if (!node->is_pending()) {
-        foreach_trace([&node_ptr](Trace &trace) { trace.set_pending(node_ptr, true); });
+        foreach_trace(TraceEvents::Pending, [&node_ptr](Trace &trace) { trace.set_pending(node_ptr, true); });
         node->set_pending(true);
     }
     if (!node->is_dirty()) {
-        foreach_trace([&node_ptr](Trace &trace) { trace.set_dirty(node_ptr, true); });
+        foreach_trace(TraceEvents::Dirty, [&node_ptr](Trace &trace) { trace.set_dirty(node_ptr, true); });
         node->set_dirty(true);
 
         IAGAttributeFlags subgraph_flags = node->subgraph_flags();
@@ -1572,26 +1816,41 @@ void *Graph::input_value_ref_slow(data::ptr<IAG::Node> node, AttributeID input,
 }
 
 bool Graph::value_set(data::ptr<Node> node, const swift::metadata &value_type, const void *value) {
-    if (!node->input_edges().empty() && node->is_value_initialized()) {
-        precondition_failure("can only set initial value of computed attributes: %u", node);
-    }
+    const swift::metadata *types[1] = {&value_type};
+    return value_set(std::span<const data::ptr<Node>>(&node, 1), types, &value) != 0;
+}
 
+uint64_t Graph::value_set(std::span<const data::ptr<Node>> nodes, const swift::metadata *const *types,
+                          const void *const *values) {
     auto update = current_update();
-    if (update.tag() == 0 && update.get() != nullptr && update.get()->graph() == this &&
-        (!node->output_edges().empty() || node->is_updating())) {
-        precondition_failure("setting value during update: %u", node);
+    bool updating = update.tag() == 0 && update.get() != nullptr && update.get()->graph() == this;
+
+    // Assign every value first, then propagate the changed attributes in a single traversal
+    auto changed_attributes = vector<AttributeID, 8, uint64_t>();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        auto node = nodes[i];
+        if (!node->input_edges().empty() && node->is_value_initialized()) {
+            precondition_failure("can only set initial value of computed attributes: %u", node);
+        }
+
+        if (updating && (!node->output_edges().empty() || node->is_updating())) {
+            precondition_failure("setting value during update: %u", node);
+        }
+
+        if (value_set_internal(node, *node.get(), values[i], *types[i])) {
+            changed_attributes.push_back(AttributeID(node));
+        }
     }
 
-    bool changed = value_set_internal(node, *node.get(), value, value_type);
-    if (changed) {
-        propagate_dirty(AttributeID(node));
+    if (!changed_attributes.empty()) {
+        propagate_dirty(std::span<const AttributeID>(changed_attributes.data(), changed_attributes.size()));
     }
-    return changed;
+    return changed_attributes.size();
 }
 
 bool Graph::value_set_internal(data::ptr<Node> node_ptr, Node &node, const void *value,
                                const swift::metadata &metadata) {
-    foreach_trace([&node_ptr, &value](Trace &trace) { trace.set_value(node_ptr, value); });
+    foreach_trace(TraceEvents::Value, [&node_ptr, &value](Trace &trace) { trace.set_value(node_ptr, value); });
 
     AttributeType &type = *_types[node.type_id()];
     if (&type.value_metadata() != &metadata) {
@@ -1621,38 +1880,46 @@ bool Graph::value_set_internal(data::ptr<Node> node_ptr, Node &node, const void
     }
 }
 
-void Graph::value_mark(data::ptr<Node> node) {
+void Graph::value_mark(data::ptr<Node> node) { value_mark(std::span<const data::ptr<Node>>(&node, 1)); }
+
+void Graph::value_mark(std::span<const data::ptr<Node>> nodes) {
     auto update = current_update();
-    if (update.tag() == 0 && update.get() != nullptr) {
-        if (update.get()->graph() == this && (!node->output_edges().empty() || node->is_updating())) {
+    bool updating = update.tag() == 0 && update.get() != nullptr && update.get()->graph() == this;
+
+    auto attributes = vector<AttributeID, 8, uint64_t>();
+    for (auto node : nodes) {
+        if (updating && (!node->output_edges().empty() || node->is_updating())) {
             // TODO: check output edges empty ORed with is_updating
             precondition_failure("setting value during update: %u", node);
         }
-    }
 
-    foreach_trace([&node](Trace &trace) { trace.mark_value(node); });
+        foreach_trace(TraceEvents::Value, [&node](Trace &trace) { trace.mark_value(node); });
 
-    const AttributeType &type = attribute_type(node->type_id());
-    if (type.flags() & IAGAttributeTypeFlagsExternal) {
-        mark_changed(node, nullptr, nullptr, nullptr);
-    } else {
-        node->set_self_modified(true); // TODO: check this
+        const AttributeType &type = attribute_type(node->type_id());
+        if (type.flags() & IAGAttributeTypeFlagsExternal) {
+            mark_changed(node, nullptr, nullptr, nullptr);
+        } else {
+            node->set_self_modified(true); // TODO: check this
 
-        if (!node->is_dirty()) {
-            foreach_trace([&node](Trace &trace) { trace.set_dirty(node, true); });
-            node->set_dirty(true);
-        }
-        if (!node->is_pending()) {
-            foreach_trace([&node](Trace &trace) { trace.set_pending(node, true); });
-            node->set_pending(true);
-        }
-        if (node->subgraph_flags()) {
-            Subgraph *subgraph = AttributeID(node).subgraph();
-            subgraph->add_dirty_flags(node->subgraph_flags());
+            if (!node->is_dirty()) {
+                foreach_trace(TraceEvents::Dirty, [&node](Trace &trace) { trace.set_dirty(node, true); });
+                node->set_dirty(true);
+            }
+            if (!node->is_pending()) {
+                foreach_trace(TraceEvents::Pending, [&node](Trace &trace) { trace.set_pending(node, true); });
+                node->set_pending(true);
+            }
+            if (node->subgraph_flags()) {
+                Subgraph *subgraph = AttributeID(node).subgraph();
+                subgraph->add_dirty_flags(node->subgraph_flags());
+            }
         }
+
+        attributes.push_back(AttributeID(node));
     }
 
-    propagate_dirty(AttributeID(node));
+    // Marking many values only walks the outputs they share once
+    propagate_dirty(std::span<const AttributeID>(attributes.data(), attributes.size()));
 }
 
 void Graph::value_mark_all() {
@@ -1685,43 +1952,90 @@ void Graph::value_mark_all() {
 }
 
 void Graph::propagate_dirty(AttributeID attribute) {
-    if (attribute.is_nil()) {
-        return;
+    propagate_dirty(std::span<const AttributeID>(&attribute, 1));
+}
+
+uint32_t Graph::next_propagation_generation() {
+    _propagation_generation += 1;
+    if (_propagation_generation == (UINT32_MAX >> 1)) {
+        // Clear the stamps before reusing generations, so an old stamp can't be mistaken for the current one
+        for (auto subgraph : _subgraphs) {
+            for (auto page : subgraph->pages()) {
+                for (auto attribute : attribute_view(page)) {
+                    if (!attribute || attribute.is_nil()) {
+                        break;
+                    }
+                    if (auto indirect_node = attribute.get_indirect_node()) {
+                        if (indirect_node->is_mutable()) {
+                            indirect_node->to_mutable().set_propagation_stamp(0);
+                        }
+                    }
+                }
+            }
+        }
+        _propagation_generation = 1;
     }
+    return _propagation_generation;
+}
 
+void Graph::propagate_dirty(std::span<const AttributeID> attributes) {
     struct Frame {
         ConstOutputEdgeArrayRef output_edges;
         NodeState state;
+        AttributeID attribute;
     };
 
     auto heap = util::InlineHeap<0x2000>();
     auto frames = util::ForwardList<Frame>(&heap);
 
-    ConstOutputEdgeArrayRef initial_output_edges = {};
-    NodeState initial_state = NodeState(0);
-    if (auto node = attribute.get_node()) {
-        initial_output_edges = {
-            &node->output_edges().front(),
-            node->output_edges().size(),
-        };
-        initial_state = node->state();
-    } else if (auto indirect_node = attribute.get_indirect_node()) {
-        // TODO: how to make sure indirect is mutable?
-        assert(indirect_node->is_mutable());
-        initial_output_edges = {
-            &indirect_node->to_mutable().output_edges().front(),
-            indirect_node->to_mutable().output_edges().size(),
-        };
-        OffsetAttributeID source = indirect_node->source().identifier().resolve(TraversalOptions::None);
-        if (auto source_node = source.attribute().get_node()) {
-            initial_state = source_node->state();
+    // Nodes are only walked when they become dirty or main thread, which happens at most once per propagation.
+    // Mutable indirect nodes have no such state, so they are stamped with the generation of the propagation instead.
+    uint32_t generation = next_propagation_generation();
+    auto visit_indirect_node = [generation](MutableIndirectNode &indirect_node, NodeState state) -> bool {
+        uint32_t main_thread = (state & NodeState::MainThread) != (NodeState)0 ? 1 : 0;
+        uint32_t stamp = indirect_node.propagation_stamp();
+        if ((stamp >> 1) == generation) {
+            if ((stamp & 1) >= main_thread) {
+                return false;
+            }
         }
+        indirect_node.set_propagation_stamp((generation << 1) | main_thread);
+        return true;
+    };
+
+    for (auto attribute : attributes) {
+        if (attribute.is_nil()) {
+            continue;
+        }
+
+        ConstOutputEdgeArrayRef initial_output_edges = {};
+        NodeState initial_state = NodeState(0);
+        if (auto node = attribute.get_node()) {
+            initial_output_edges = {
+                &node->output_edges().front(),
+                node->output_edges().size(),
+            };
+            initial_state = node->state();
+        } else if (auto indirect_node = attribute.get_indirect_node()) {
+            // TODO: how to make sure indirect is mutable?
+            assert(indirect_node->is_mutable());
+            initial_output_edges = {
+                &indirect_node->to_mutable().output_edges().front(),
+                indirect_node->to_mutable().output_edges().size(),
+            };
+            OffsetAttributeID source = indirect_node->source().identifier().resolve(TraversalOptions::None);
+            if (auto source_node = source.attribute().get_node()) {
+                initial_state = source_node->state();
+            }
+            visit_indirect_node(indirect_node->to_mutable(), initial_state);
+        }
+        frames.emplace_front(initial_output_edges, initial_state, attribute);
     }
-    frames.emplace_front(initial_output_edges, initial_state);
 
     while (!frames.empty()) {
         auto &output_edges = frames.front().output_edges;
         auto state = frames.front().state;
+        auto attribute = frames.front().attribute;
         frames.pop_front();
 
         for (auto output_edge : std::ranges::reverse_view(output_edges)) {
@@ -1742,7 +2056,9 @@ void Graph::propagate_dirty(AttributeID attribute) {
                 next_state = state | output_node->state();
 
                 if (!output_node->is_dirty()) {
-                    foreach_trace([&output_node](Trace &trace) { trace.set_dirty(output_node, true); });
+                    foreach_trace(TraceEvents::Dirty, [&output_node](Trace &trace) {
+                        trace.set_dirty(output_node, true);
+                    });
 
                     output_node->set_dirty(true);
                     if (auto subgraph = AttributeID(output_node).subgraph()) {
@@ -1769,7 +2085,8 @@ void Graph::propagate_dirty(AttributeID attribute) {
                 }
 
             } else if (auto output_indirect_node = output.get_indirect_node()) {
-                if (output_indirect_node->is_mutable()) {
+                if (output_indirect_node->is_mutable() &&
+                    visit_indirect_node(output_indirect_node->to_mutable(), state)) {
                     dirty_output_edges = {
                         &output_indirect_node->to_mutable().output_edges().front(),
                         output_indirect_node->to_mutable().output_edges().size(),
@@ -1792,7 +2109,7 @@ void Graph::propagate_dirty(AttributeID attribute) {
             }
 
             if (!dirty_output_edges.empty()) {
-                frames.emplace_front(dirty_output_edges, next_state);
+                frames.emplace_front(dirty_output_edges, next_state, attribute);
             }
         }
     }
@@ -1994,6 +2311,7 @@ void Graph::add_trace(Trace *_Nullable trace) {
     }
     trace->begin_trace(*this);
     _traces.push_back(trace);
+    _trace_events |= trace->events();
 }
 
 void Graph::remove_trace(IAGUniqueID trace_id) {
@@ -2004,6 +2322,11 @@ void Graph::remove_trace(IAGUniqueID trace_id) {
         trace->end_trace(*this);
         trace->trace_removed();
         _traces.erase(iter, _traces.end());
+
+        _trace_events = TraceEvents::None;
+        for (auto remaining_trace : _traces) {
+            _trace_events |= remaining_trace->events();
+        }
     }
 }
 
@@ -2047,7 +2370,7 @@ void Graph::trace_assertion_failure(bool all_stop_tracing, const char *format, .
 
     bool locked = all_try_lock();
     for (auto graph = _all_graphs; graph != nullptr; graph = graph->_next) {
-        graph->foreach_trace([&format, &args](Trace &trace) { trace.log_message_v(format, args); });
+        graph->foreach_trace(TraceEvents::Log, [&format, &args](Trace &trace) { trace.log_message_v(format, args); });
         if (all_stop_tracing) {
             graph->stop_tracing();
         }
@@ -2080,6 +2403,48 @@ const char *Graph::key_name(uint32_t key_id) const {
     IAG::precondition_failure("invalid string key id: %u", key_id);
 }
 
+#pragma mark - Tree
+
+// Indexes subgraphs by the attribute owning their tree root, so that the subgraph children of a tree element can be
+// found without visiting every subgraph. Owners that aren't direct attributes can resolve to a different node over
+// time, so those subgraphs are kept in a list that is resolved on lookup.
+void Graph::set_tree_owner(Subgraph *subgraph, AttributeID old_owner, AttributeID new_owner) {
+    if (old_owner == new_owner) {
+        return;
+    }
+
+    if (old_owner && !old_owner.is_nil()) {
+        if (old_owner.is_node()) {
+            if (_tree_subgraphs_by_owner) {
+                auto range = _tree_subgraphs_by_owner->equal_range(old_owner);
+                for (auto iter = range.first; iter != range.second; ++iter) {
+                    if (iter->second == subgraph) {
+                        _tree_subgraphs_by_owner->erase(iter);
+                        break;
+                    }
+                }
+            }
+        } else {
+            auto iter = std::find(_tree_subgraphs_with_indirect_owner.begin(),
+                                  _tree_subgraphs_with_indirect_owner.end(), subgraph);
+            if (iter != _tree_subgraphs_with_indirect_owner.end()) {
+                _tree_subgraphs_with_indirect_owner.erase(iter);
+            }
+        }
+    }
+
+    if (new_owner && !new_owner.is_nil()) {
+        if (new_owner.is_node()) {
+            if (!_tree_subgraphs_by_owner) {
+                _tree_subgraphs_by_owner.reset(new std::unordered_multimap<IAGAttribute, Subgraph *>());
+            }
+            _tree_subgraphs_by_owner->emplace(new_owner, subgraph);
+        } else {
+            _tree_subgraphs_with_indirect_owner.push_back(subgraph);
+        }
+    }
+}
+
 #pragma mark - Encoding
 
 void Graph::encode_node(Encoder &encoder, const Node &node, bool encode_value) const {
@@ -2213,7 +2578,9 @@ int trap_cycles() {
 } // namespace
 
 void Graph::print_cycle(data::ptr<Node> node) {
-    foreach_trace([&node](Trace &trace) { trace.log_message("cycle detected through attribute: %u", node); });
+    foreach_trace(TraceEvents::Log, [&node](Trace &trace) {
+        trace.log_message("cycle detected through attribute: %u", node);
+    });
 
     static int verbosity = cycle_verbosity();
     if (verbosity >= 1) {
@@ -2,9 +2,11 @@
 
 #include "ComputeCxx/IAGBase.h"
 
+#include <atomic>
 #include <memory>
 #include <ranges>
 #include <span>
+#include <unordered_map>
 
 #if TARGET_OS_MAC
 #ifdef __OBJC__
@@ -17,11 +19,13 @@
 #include <Utilities/TaggedPointer.h>
 #include <platform/lock.h>
 
+#include "Attribute/AttributeData/Edge/OutputEdge.h"
 #include "Attribute/AttributeID/AttributeID.h"
 #include "Attribute/AttributeType/AttributeType.h"
 #include "Closure/ClosureFunction.h"
 #include "ComputeCxx/IAGGraphTracing.h"
 #include "Swift/Metadata.h"
+#include "Trace/TraceEvents.h"
 #include "Vector/Vector.h"
 
 IAG_ASSUME_NONNULL_BEGIN
@@ -39,6 +43,7 @@ class Graph {
     class TreeValue;
     class TreeValueID;
     class KeyTable;
+    class ProfileData;
     class UpdateStack;
     class TraceRecorder;
 
@@ -59,6 +64,13 @@ class Graph {
         void push_back(TreeElementNodePair pair) { _nodes.push_back(pair); };
     };
 
+    // Links the idle node cache items of all subgraphs, so they can be evicted least recently used first
+    struct NodeCacheEntry {
+        NodeCacheEntry *_Nullable lru_prev = nullptr;
+        NodeCacheEntry *_Nullable lru_next = nullptr;
+        uint64_t lru_size = 0;
+    };
+
     enum class UpdateStatus : uint32_t {
         Unchanged = 0,
         Changed = 1,
@@ -87,6 +99,7 @@ class Graph {
 
     // Trace
     vector<Trace *, 0, uint32_t> _traces;
+    TraceEvents _trace_events = TraceEvents::None; // union of the events of all traces
 
     // Main thread handler
     MainHandler _Nullable _main_handler = nullptr;
@@ -104,8 +117,34 @@ class Graph {
 
     // Tree
     std::unique_ptr<std::unordered_map<Subgraph *, TreeDataElement>> _tree_data_elements_by_subgraph;
+    std::unique_ptr<std::unordered_multimap<IAGAttribute, Subgraph *>> _tree_subgraphs_by_owner;
+    vector<Subgraph *, 0, uint32_t> _tree_subgraphs_with_indirect_owner;
     KeyTable *_Nullable _keys = nullptr;
 
+    // Output edges
+    // An attribute may be the output of the same input more than once, so each output maps to all of its positions
+    using OutputEdgeIndex = std::unordered_multimap<IAGAttribute, uint32_t>;
+    std::unordered_map<IAGAttribute, OutputEdgeIndex> _output_edge_indices;
+
+    // Node cache
+    NodeCacheEntry *_Nullable _node_cache_lru = nullptr;
+    NodeCacheEntry *_Nullable _node_cache_mru = nullptr;
+    uint64_t _node_cache_bytes = 0;
+    uint64_t _node_cache_budget;
+    uint64_t _node_cache_hits = 0;
+    uint64_t _node_cache_misses = 0;
+    uint64_t _node_cache_evictions = 0;
+
+    // Indirect resolution
+    // Indirect nodes are resolved on any thread, counters are incremented without read-modify-write and may miss counts
+    std::atomic<uint32_t> _indirect_resolution_epoch = 1;
+    std::atomic<uint64_t> _indirect_resolution_hits = 0;
+    std::atomic<uint64_t> _indirect_resolution_misses = 0;
+
+    // Profile
+    ProfileData *_Nullable _profile_data = nullptr;
+    std::atomic<bool> _is_profiling = false; // read by updates on any thread
+
     // Subgraphs
     vector<Subgraph *, 0, uint32_t> _subgraphs;
     vector<Subgraph *, 0, uint32_t> _subgraphs_with_cached_nodes;
@@ -127,6 +166,9 @@ class Graph {
     uint64_t _change_count = 0;
     uint64_t _version = 0;
 
+    // Dirty propagation
+    uint32_t _propagation_generation = 0;
+
     static void all_lock() { platform_lock_lock(&_all_graphs_lock); };
     static bool all_try_lock() { return platform_lock_trylock(&_all_graphs_lock); };
     static void all_unlock() { platform_lock_unlock(&_all_graphs_lock); };
@@ -137,7 +179,8 @@ class Graph {
 
     // Attributes utility methods
 
-    void remove_removed_input(AttributeID attribute, AttributeID input);
+    void remove_removed_input(AttributeID attribute, AttributeID input,
+                              vector<AttributeID, 0, uint64_t> *_Nullable surviving_inputs = nullptr);
     bool remove_removed_output(AttributeID attribute, AttributeID output, bool option);
 
     void remove_input(data::ptr<Node> node, uint32_t index);
@@ -152,6 +195,15 @@ class Graph {
     template <> void remove_output_edge<Node>(data::ptr<Node> node, AttributeID output);
     template <> void remove_output_edge<MutableIndirectNode>(data::ptr<MutableIndirectNode> node, AttributeID output);
 
+    // Attributes with many outputs keep an index from each output to its position in the output edges, so that
+    // removing an edge doesn't search the whole vector.
+    static constexpr uint32_t output_edge_index_threshold = 64;
+
+    void insert_output_edge(AttributeID attribute, data::vector<OutputEdge> &output_edges, data::zone *zone,
+                            AttributeID output);
+    void erase_output_edge(AttributeID attribute, data::vector<OutputEdge> &output_edges, AttributeID output);
+    void discard_output_edge_index(AttributeID attribute) { _output_edge_indices.erase(attribute); };
+
     void add_input_dependencies(AttributeID attribute, AttributeID input);
     void remove_input_dependencies(AttributeID attribute, AttributeID input);
     void update_main_refs(AttributeID attribute);
@@ -233,6 +285,22 @@ class Graph {
         tree_data_element.push_back({tree_element, node});
     };
 
+    void set_tree_owner(Subgraph *subgraph, AttributeID old_owner, AttributeID new_owner);
+
+    template <typename Body> void foreach_tree_subgraph_owned_by(data::ptr<Node> node, Body body) const {
+        if (!_tree_subgraphs_by_owner) {
+            return;
+        }
+        auto range = _tree_subgraphs_by_owner->equal_range(AttributeID(node));
+        for (auto iter = range.first; iter != range.second; ++iter) {
+            body(iter->second);
+        }
+    };
+
+    const vector<Subgraph *, 0, uint32_t> &tree_subgraphs_with_indirect_owner() const {
+        return _tree_subgraphs_with_indirect_owner;
+    };
+
     // MARK: Subgraphs
 
     vector<Subgraph *, 0, uint32_t> &subgraphs() { return _subgraphs; };
@@ -273,12 +341,57 @@ class Graph {
     void will_invalidate_subgraph() { _deferring_subgraph_invalidation = true; }
     void did_invalidate_subgraph() { _deferring_subgraph_invalidation = false; }
 
+    // MARK: Node cache
+
+    uint64_t node_cache_budget() const { return _node_cache_budget; };
+    void set_node_cache_budget(uint64_t budget) { _node_cache_budget = budget; };
+
+    uint64_t node_cache_bytes() const { return _node_cache_bytes; };
+    uint64_t node_cache_hits() const { return _node_cache_hits; };
+    uint64_t node_cache_misses() const { return _node_cache_misses; };
+    uint64_t node_cache_evictions() const { return _node_cache_evictions; };
+
+    void did_hit_node_cache() { _node_cache_hits += 1; };
+    void did_miss_node_cache() { _node_cache_misses += 1; };
+
+    // MARK: Indirect resolution
+
+    /// The epoch that resolutions of indirect nodes in this graph are memoized for.
+    uint32_t indirect_resolution_epoch() const { return _indirect_resolution_epoch.load(std::memory_order_acquire); };
+
+    /// Discards the memoized resolutions of all indirect nodes in this graph. Must be called whenever the source or
+    /// dependency of an indirect node changes, or weak references into a subgraph expire.
+    void invalidate_indirect_resolutions() {
+        // skip 0, which marks nodes that were never resolved
+        if (_indirect_resolution_epoch.fetch_add(1, std::memory_order_release) + 1 == 0) {
+            _indirect_resolution_epoch.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    uint64_t indirect_resolution_hits() const { return _indirect_resolution_hits.load(std::memory_order_relaxed); };
+    uint64_t indirect_resolution_misses() const { return _indirect_resolution_misses.load(std::memory_order_relaxed); };
+
+    void did_hit_indirect_resolution() {
+        _indirect_resolution_hits.store(_indirect_resolution_hits.load(std::memory_order_relaxed) + 1,
+                                        std::memory_order_relaxed);
+    };
+    void did_miss_indirect_resolution() {
+        _indirect_resolution_misses.store(_indirect_resolution_misses.load(std::memory_order_relaxed) + 1,
+                                          std::memory_order_relaxed);
+    };
+
+    void node_cache_link(NodeCacheEntry &entry, uint64_t size);
+    void node_cache_unlink(NodeCacheEntry &entry);
+    void evict_node_cache_entries();
+
     // MARK: Metrics
 
     uint64_t num_nodes() const { return _num_nodes; };
     uint64_t num_nodes_total() const { return _num_nodes_total; };
     uint64_t num_subgraphs() const { return _num_subgraphs; };
     uint64_t num_subgraphs_total() const { return _num_subgraphs_total; };
+    uint64_t num_recycled_allocations() const;
+    uint64_t num_recycled_bytes() const;
 
     // MARK: Attribute types
 
@@ -293,8 +406,11 @@ class Graph {
     data::ptr<IndirectNode> add_indirect_attribute(Subgraph &subgraph, AttributeID attribute, uint32_t offset,
                                                    std::optional<size_t> size, bool is_mutable);
 
-    void remove_node(data::ptr<Node> node);
-    void remove_indirect_node(data::ptr<IndirectNode> node);
+    // Nodes are removed in batches when their subgraphs are invalidated. Output edges of inputs in surviving
+    // subgraphs are collected into surviving_inputs and unlinked once per input by remove_removed_outputs.
+    void remove_node(data::ptr<Node> node, vector<AttributeID, 0, uint64_t> &surviving_inputs);
+    void remove_indirect_node(data::ptr<IndirectNode> node, vector<AttributeID, 0, uint64_t> &surviving_inputs);
+    void remove_removed_outputs(vector<AttributeID, 0, uint64_t> &surviving_inputs);
 
     uint32_t add_input(data::ptr<Node> node, AttributeID input, bool allow_nil, IAGInputOptions options);
     void remove_all_inputs(data::ptr<Node> node);
@@ -327,12 +443,17 @@ class Graph {
                           const swift::metadata &value_type, IAGChangedValueFlags *_Nonnull flags_out);
 
     bool value_set(data::ptr<Node> node, const swift::metadata &metadata, const void *value);
+    uint64_t value_set(std::span<const data::ptr<Node>> nodes, const swift::metadata *_Nonnull const *_Nonnull types,
+                       const void *_Nonnull const *_Nonnull values);
     bool value_set_internal(data::ptr<Node> node_ptr, Node &node, const void *value, const swift::metadata &metadata);
 
     void value_mark(data::ptr<Node> node);
+    void value_mark(std::span<const data::ptr<Node>> nodes);
     void value_mark_all();
 
     void propagate_dirty(AttributeID attribute);
+    void propagate_dirty(std::span<const AttributeID> attributes);
+    uint32_t next_propagation_generation();
 
     bool any_inputs_changed(data::ptr<Node> node, const AttributeID *exclude_attributes,
                             uint64_t exclude_attributes_count);
@@ -345,6 +466,20 @@ class Graph {
     void did_destroy_value(size_t size) { _num_value_bytes -= size; };
     void did_destroy_node() { _num_nodes -= 1; };
 
+    // MARK: Profile
+
+    bool is_profiling() const { return _is_profiling.load(std::memory_order_acquire); };
+    void start_profiling();
+    void stop_profiling() { _is_profiling.store(false, std::memory_order_release); };
+    void reset_profile();
+
+    ProfileData *_Nullable profile_data() const { return _profile_data; };
+    void record_profile_update(data::ptr<Node> node, uint64_t duration);
+
+    static void all_start_profiling();
+    static void all_stop_profiling();
+    static void all_reset_profile();
+
     // MARK: Update
 
     static util::tagged_ptr<UpdateStack> current_update() {
@@ -419,6 +554,14 @@ class Graph {
         }
     };
 
+    TraceEvents trace_events() const { return _trace_events; };
+    bool has_trace_events(TraceEvents events) const { return (_trace_events & events) != TraceEvents::None; };
+
+    // Only visits traces that consume one of events, defined in Trace.h
+    template <typename T>
+        requires std::invocable<T, Trace &>
+    void foreach_trace(TraceEvents events, T body);
+
     // MARK: Keys
 
     uint32_t intern_key(const char *key);
@@ -451,9 +594,14 @@ class Graph {
     NSArray *description_stack_nodes(NSDictionary *options);
     NSDictionary *description_stack_frame(NSDictionary *options);
 #endif
+#endif
+
+    static bool export_json(Graph *_Nullable graph, int fd, bool include_values, bool all_graphs);
+    bool export_dot(int fd, bool include_values);
+
+    bool write_snapshot(int fd);
 
     static void write_to_file(Graph *_Nullable graph, const char *_Nullable filename, bool exclude_values);
-#endif
 };
 
 } // namespace IAG
@@ -74,7 +74,9 @@ int trap_cycles() {
 } // namespace
 
 void Graph::print_cycle(data::ptr<Node> node) {
-    foreach_trace([&node](Trace &trace) { trace.log_message("cycle detected through attribute: %u", node); });
+    foreach_trace(TraceEvents::Log, [&node](Trace &trace) {
+        trace.log_message("cycle detected through attribute: %u", node);
+    });
 
     static int verbosity = cycle_verbosity();
     if (verbosity >= 1) {
@@ -0,0 +1,718 @@
+#include "Graph.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <unistd.h>
+
+#include <Utilities/FlatTable.h>
+
+#include "Attribute/AttributeData/Node/IndirectNode.h"
+#include "Attribute/AttributeData/Node/Node.h"
+#include "Attribute/AttributeID/OffsetAttributeID.h"
+#include "Attribute/AttributeView/AttributeView.h"
+#include "Data/Table.h"
+#include "FileWriter.h"
+#include "Subgraph/Subgraph.h"
+#include "Tree/TreeElement.h"
+
+namespace IAG {
+
+namespace {
+
+template <typename T> struct PointerHash {
+    uint64_t operator()(data::ptr<T> pointer) const noexcept { return util::mix_hash(pointer.offset()); }
+};
+
+// Writes JSON to a FileWriter, inserting the commas between members and elements.
+class JSONWriter {
+  private:
+    FileWriter &_file;
+    uint64_t _needs_comma = 0; // one bit per nesting level
+
+    void will_write_value() {
+        if (_needs_comma & 1) {
+            _file.write(',');
+        }
+        _needs_comma |= 1;
+    };
+
+  public:
+    explicit JSONWriter(FileWriter &file) : _file(file) {};
+
+    FileWriter &file() { return _file; };
+
+    void begin_object() {
+        will_write_value();
+        _file.write('{');
+        _needs_comma <<= 1;
+    };
+    void end_object() {
+        _needs_comma >>= 1;
+        _file.write('}');
+    };
+
+    void begin_array() {
+        will_write_value();
+        _file.write('[');
+        _needs_comma <<= 1;
+    };
+    void end_array() {
+        _needs_comma >>= 1;
+        _file.write(']');
+    };
+
+    // Writes the key of the next object member, which must be followed by exactly one value.
+    void key(const char *name) {
+        will_write_value();
+        _file.write('"');
+        _file.write_escaped(name, SIZE_MAX, true);
+        _file.write("\":");
+        _needs_comma &= ~uint64_t(1);
+    };
+
+    void value(uint64_t value) {
+        will_write_value();
+        _file.write_uint(value);
+    };
+    void value(bool value) {
+        will_write_value();
+        _file.write(value ? "true" : "false");
+    };
+    void value(const char *string, size_t truncation_limit) {
+        will_write_value();
+        _file.write('"');
+        _file.write_escaped(string, truncation_limit, true);
+        _file.write('"');
+    };
+    void value(CFStringRef string, size_t truncation_limit) {
+        will_write_value();
+        _file.write('"');
+        _file.write_escaped(string, truncation_limit, true);
+        _file.write('"');
+    };
+};
+
+// Calls the body with the description of an attribute's body or value, if its type provides one.
+template <typename Body> void with_self_description(const AttributeType &type, void *self, Body body) {
+#if TARGET_OS_MAC
+    if (auto description = type.self_description(self)) {
+        body(description);
+    }
+#else
+    if (auto description = type.copy_self_description(self)) {
+        body(description);
+        CFRelease(description);
+    }
+#endif
+}
+
+template <typename Body> void with_value_description(const AttributeType &type, void *value, Body body) {
+#if TARGET_OS_MAC
+    if (auto description = type.value_description(value)) {
+        body(description);
+    }
+#else
+    if (auto description = type.copy_value_description(value)) {
+        body(description);
+        CFRelease(description);
+    }
+#endif
+}
+
+constexpr size_t json_truncation_limit = 1024;
+constexpr size_t dot_truncation_limit = 40;
+
+template <typename PushGraph>
+void write_graph_json(JSONWriter &json, Graph &graph, bool include_values, PushGraph &push_graph) {
+    json.begin_object();
+    json.key("id");
+    json.value(graph.id());
+
+    json.key("counters");
+    json.begin_object();
+    json.key("nodes");
+    json.value(graph.num_nodes());
+    json.key("created_nodes");
+    json.value(graph.num_nodes_total());
+    json.key("max_nodes");
+    json.value(graph.num_nodes_total());
+    json.key("subgraphs");
+    json.value(graph.num_subgraphs());
+    json.key("created_subgraphs");
+    json.value(graph.num_subgraphs_total());
+    json.key("max_subgraphs");
+    json.value(graph.num_subgraphs_total());
+    json.key("updates");
+    json.value(graph.update_count());
+    json.key("changes");
+    json.value(graph.change_count());
+    json.key("transactions");
+    json.value(graph.transaction_count());
+    json.end_object();
+
+    json.key("transaction_count");
+    json.value(graph.transaction_count());
+    json.key("update_count");
+    json.value(graph.update_count());
+    json.key("change_count");
+    json.value(graph.change_count());
+
+    // Nodes, numbering nodes and types in the order they are written. Indices are stored plus one so that a missing
+    // entry can be told apart.
+    auto node_indices = util::FlatTable<data::ptr<Node>, uint64_t, PointerHash<Node>>();
+    auto type_indices = util::FlatTable<uint32_t, uint64_t>();
+    auto type_ids = vector<uint32_t, 0, uint64_t>();
+    node_indices.reserve(graph.num_nodes());
+
+    json.key("nodes");
+    json.begin_array();
+    for (auto subgraph : graph.subgraphs()) {
+        for (auto page : subgraph->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                auto node = attribute.get_node();
+                if (!node) {
+                    continue;
+                }
+
+                node_indices.insert(node, node_indices.count() + 1);
+
+                uint32_t type_id = node->type_id();
+                uint64_t type_index = type_indices.lookup(type_id, nullptr);
+                if (type_index == 0) {
+                    type_ids.push_back(type_id);
+                    type_index = type_ids.size();
+                    type_indices.insert(type_id, type_index);
+                }
+
+                json.begin_object();
+                json.key("type");
+                json.value(type_index - 1);
+                json.key("id");
+                json.value(uint64_t(node.offset()));
+
+                const AttributeType &type = graph.attribute_type(type_id);
+                if (node->is_self_initialized()) {
+                    with_self_description(type, node->get_self(type), [&json](CFStringRef description) {
+                        json.key("desc");
+                        json.value(description, json_truncation_limit);
+                    });
+                }
+                if (include_values && node->is_value_initialized()) {
+                    with_value_description(type, node->get_value(), [&json](CFStringRef description) {
+                        json.key("value");
+                        json.value(description, json_truncation_limit);
+                    });
+                }
+
+                if (auto flags = node->flags()) {
+                    json.key("flags");
+                    json.value(uint64_t(flags));
+                }
+                if (auto subgraph_flags = node->subgraph_flags()) {
+                    json.key("subgraph_flags");
+                    json.value(uint64_t(subgraph_flags));
+                }
+                json.end_object();
+            }
+        }
+    }
+    json.end_array();
+
+    auto node_index = [&node_indices](data::ptr<Node> node) -> std::optional<uint64_t> {
+        uint64_t index = node_indices.lookup(node, nullptr);
+        return index ? std::optional<uint64_t>(index - 1) : std::optional<uint64_t>();
+    };
+
+    // Types
+    json.key("types");
+    json.begin_array();
+    for (auto type_id : type_ids) {
+        const AttributeType &type = graph.attribute_type(type_id);
+        json.begin_object();
+        json.key("id");
+        json.value(uint64_t(type_id));
+        json.key("name");
+        json.value(type.body_metadata().name(false), json_truncation_limit);
+        json.key("value");
+        json.value(type.value_metadata().name(false), json_truncation_limit);
+        json.key("size");
+        json.value(uint64_t(type.body_metadata().vw_size() + type.value_metadata().vw_size()));
+        json.key("flags");
+        json.value(uint64_t(type.flags()));
+        json.end_object();
+    }
+    json.end_array();
+
+    // Edges
+    json.key("edges");
+    json.begin_array();
+    for (auto subgraph : graph.subgraphs()) {
+        for (auto page : subgraph->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                auto node = attribute.get_node();
+                if (!node) {
+                    continue;
+                }
+
+                for (auto &input_edge : node->input_edges()) {
+                    OffsetAttributeID resolved = input_edge.attribute.resolve(TraversalOptions::None);
+                    auto input_node = resolved.attribute().get_node();
+                    if (!input_node) {
+                        continue;
+                    }
+                    auto src = node_index(input_node);
+                    auto dst = node_index(node);
+                    if (!src || !dst) {
+                        continue;
+                    }
+
+                    json.begin_object();
+                    json.key("src");
+                    json.value(*src);
+                    json.key("dst");
+                    json.value(*dst);
+                    bool indirect = input_edge.attribute.is_indirect_node();
+                    if (indirect && resolved.offset()) {
+                        json.key("offset");
+                        json.value(uint64_t(resolved.offset()));
+                    }
+                    if (indirect || input_edge.options & IAGInputOptionsAlwaysEnabled ||
+                        input_edge.options & IAGInputOptionsChanged || input_edge.options & IAGInputOptionsEnabled ||
+                        input_edge.options & IAGInputOptionsUnprefetched) {
+                        json.key("flags");
+                        json.value(uint64_t(input_edge.options));
+                    }
+                    json.end_object();
+                }
+            }
+        }
+    }
+    json.end_array();
+
+    // Subgraphs
+    auto write_subgraph_reference = [&graph, &json, &push_graph](Subgraph *other) {
+        if (other->graph() == &graph) {
+            // subgraphs are kept sorted by address
+            auto found = std::lower_bound(graph.subgraphs().begin(), graph.subgraphs().end(), other);
+            if (found != graph.subgraphs().end() && *found == other) {
+                json.value(uint64_t(found - graph.subgraphs().begin()));
+                return;
+            }
+        }
+        json.begin_object();
+        json.key("graph");
+        json.value(push_graph(other->graph()));
+        json.key("subgraph_id");
+        json.value(other->subgraph_id());
+        json.end_object();
+    };
+
+    json.key("subgraphs");
+    json.begin_array();
+    for (auto subgraph : graph.subgraphs()) {
+        json.begin_object();
+        json.key("id");
+        json.value(subgraph->subgraph_id());
+        json.key("context_id");
+        json.value(subgraph->context_id());
+        if (!subgraph->is_valid()) {
+            json.key("invalid");
+            json.value(true);
+        }
+
+        if (!subgraph->parents().empty()) {
+            json.key("parents");
+            json.begin_array();
+            for (Subgraph *parent : subgraph->parents()) {
+                write_subgraph_reference(parent);
+            }
+            json.end_array();
+        }
+
+        if (!subgraph->children().empty()) {
+            json.key("children");
+            json.begin_array();
+            for (auto child : subgraph->children()) {
+                write_subgraph_reference(child.subgraph());
+            }
+            json.end_array();
+        }
+
+        bool has_nodes = false;
+        for (auto page : subgraph->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                auto node = attribute.get_node();
+                if (!node) {
+                    continue;
+                }
+                if (auto index = node_index(node)) {
+                    if (!has_nodes) {
+                        json.key("nodes");
+                        json.begin_array();
+                        has_nodes = true;
+                    }
+                    json.value(*index);
+                }
+            }
+        }
+        if (has_nodes) {
+            json.end_array();
+        }
+
+        json.end_object();
+    }
+    json.end_array();
+
+    // Trees
+    if (graph.has_tree_data()) {
+        auto tree_indices = util::FlatTable<data::ptr<Graph::TreeElement>, uint64_t, PointerHash<Graph::TreeElement>>();
+        auto trees = vector<data::ptr<Graph::TreeElement>, 0, uint64_t>();
+        auto tree_stack = vector<data::ptr<Graph::TreeElement>, 0, uint64_t>();
+        for (auto subgraph : graph.subgraphs()) {
+            if (data::ptr<Graph::TreeElement> tree_root = subgraph->tree_root()) {
+                tree_stack.push_back(tree_root);
+            }
+            while (!tree_stack.empty()) {
+                data::ptr<Graph::TreeElement> tree = tree_stack.back();
+                tree_stack.pop_back();
+                if (tree_indices.lookup(tree, nullptr) != 0) {
+                    continue;
+                }
+                trees.push_back(tree);
+                tree_indices.insert(tree, trees.size());
+                if (tree->next_sibling) {
+                    tree_stack.push_back(tree->next_sibling);
+                }
+                if (tree->first_child) {
+                    tree_stack.push_back(tree->first_child);
+                }
+            }
+        }
+
+        json.key("trees");
+        json.begin_array();
+        for (auto tree : trees) {
+            json.begin_object();
+
+            if (tree->value && tree->type != nullptr) {
+                OffsetAttributeID resolved = tree->value.resolve(TraversalOptions::ReportIndirectionInOffset);
+                if (auto index = resolved.attribute().is_node() ? node_index(resolved.attribute().get_node())
+                                                                : std::optional<uint64_t>()) {
+                    json.key("node");
+                    json.value(*index);
+                    if (resolved.offset() != 0) {
+                        json.key("offset");
+                        json.value(uint64_t(resolved.offset() - 1));
+                    }
+                }
+                json.key("desc");
+                json.value(tree->type->name(false), json_truncation_limit);
+                if (tree->parent == nullptr) {
+                    json.key("root");
+                    json.value(true);
+                }
+            } else if (tree->value && tree->value.is_node() && tree->type == nullptr) {
+                if (auto index = node_index(tree->value.get_node())) {
+                    json.key("node");
+                    json.value(*index);
+                }
+            } else if (tree->parent == nullptr) {
+                json.key("root");
+                json.value(true);
+            }
+
+            if (tree->flags) {
+                json.key("flags");
+                json.value(uint64_t(tree->flags));
+            }
+
+            if (tree->first_child) {
+                json.key("children");
+                json.begin_array();
+                for (data::ptr<Graph::TreeElement> child = tree->first_child; child != nullptr;
+                     child = child->next_sibling) {
+                    json.value(tree_indices.lookup(child, nullptr) - 1);
+                }
+                json.end_array();
+            }
+
+            Subgraph *subgraph = Graph::TreeElementID(tree).subgraph();
+            if (auto tree_data_element = graph.tree_data_element_for_subgraph(subgraph)) {
+                // nodes are sorted by the offset of their tree element
+                auto &data_nodes = tree_data_element->nodes();
+                auto found = std::lower_bound(data_nodes.begin(), data_nodes.end(), tree.offset(),
+                                              [](auto &element_node, uint32_t offset) {
+                                                  return element_node.first.offset() < offset;
+                                              });
+                if (found != data_nodes.end() && found->first == tree) {
+                    json.key("nodes");
+                    json.begin_array();
+                    for (auto element_node = found; element_node != data_nodes.end(); ++element_node) {
+                        if (element_node->first != tree) {
+                            break;
+                        }
+                        if (auto index = element_node->second ? node_index(element_node->second)
+                                                              : std::optional<uint64_t>()) {
+                            json.value(*index);
+                        }
+                    }
+                    json.end_array();
+                }
+            }
+
+            json.key("values");
+            json.begin_object();
+            for (data::ptr<Graph::TreeValue> value = tree->first_value; value != nullptr; value = value->next) {
+                OffsetAttributeID resolved_value = value->value.resolve(TraversalOptions::None);
+                if (!resolved_value.attribute() || !resolved_value.attribute().is_node()) {
+                    continue;
+                }
+                auto index = node_index(resolved_value.attribute().get_node());
+                if (!index) {
+                    continue;
+                }
+                json.key(graph.key_name(value->key_id));
+                json.begin_object();
+                json.key("node");
+                json.value(*index);
+                if (resolved_value.offset() != 0) {
+                    json.key("offset");
+                    json.value(uint64_t(resolved_value.offset()));
+                }
+                json.end_object();
+            }
+            json.end_object();
+
+            json.end_object();
+        }
+        json.end_array();
+    }
+
+    json.end_object();
+}
+
+} // namespace
+
+#pragma mark - JSON
+
+bool Graph::export_json(Graph *graph, int fd, bool include_values, bool all_graphs) {
+    FileWriter file = FileWriter(fd);
+    JSONWriter json = JSONWriter(file);
+
+    // Graphs are written in the order they are pushed, including graphs that are pushed while writing the subgraphs
+    // of another graph because they have parents or children in it
+    auto graphs = vector<Graph *, 0, uint64_t>();
+    auto push_graph = [&graphs](Graph *graph) -> uint64_t {
+        auto found = std::find(graphs.begin(), graphs.end(), graph);
+        if (found != graphs.end()) {
+            return found - graphs.begin();
+        }
+        graphs.push_back(graph);
+        return graphs.size() - 1;
+    };
+    if (graph) {
+        push_graph(graph);
+    }
+    if (all_graphs) {
+        all_lock();
+        for (auto other_graph = _all_graphs; other_graph != nullptr; other_graph = other_graph->_next) {
+            push_graph(other_graph);
+        }
+        all_unlock();
+    }
+
+    json.begin_object();
+    json.key("version");
+    json.value(uint64_t(2));
+
+    json.key("counters");
+    json.begin_object();
+    json.key("bytes");
+    json.value(uint64_t(data::table::shared().bytes()));
+    json.key("max_bytes");
+    json.value(uint64_t(data::table::shared().max_bytes()));
+    json.end_object();
+
+    json.key("graphs");
+    json.begin_array();
+    for (uint64_t graph_index = 0; graph_index < graphs.size(); ++graph_index) {
+        write_graph_json(json, *graphs[graph_index], include_values, push_graph);
+    }
+    json.end_array();
+
+    json.end_object();
+    file.write('\n');
+
+    file.flush();
+    return !file.failed();
+}
+
+#pragma mark - DOT
+
+bool Graph::export_dot(int fd, bool include_values) {
+    FileWriter file = FileWriter(fd);
+
+    file.write("digraph {\n");
+
+    auto indirect_nodes = util::FlatTable<data::ptr<IndirectNode>, util::FlatNoValue, PointerHash<IndirectNode>>();
+
+    for (auto subgraph : subgraphs()) {
+        for (auto page : subgraph->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                auto node = attribute.get_node();
+                if (!node) {
+                    continue;
+                }
+
+                file.write("  _");
+                file.write_uint(IAGAttribute(attribute));
+                file.write("[label=\"");
+                file.write_uint(IAGAttribute(attribute));
+
+                const AttributeType &type = attribute_type(node->type_id());
+                if (node->is_self_initialized()) {
+                    with_self_description(type, node->get_self(type), [&file](CFStringRef description) {
+                        file.write(": ");
+                        file.write_escaped(description, dot_truncation_limit, false);
+                    });
+                }
+                if (include_values && node->is_value_initialized()) {
+                    with_value_description(type, node->get_value(), [&file](CFStringRef description) {
+                        file.write(" → ");
+                        file.write_escaped(description, dot_truncation_limit, false);
+                    });
+                }
+                file.write('"');
+
+                bool filled = false;
+                if (node->is_updating()) {
+                    file.write(" fillcolor=cyan");
+                    filled = true;
+                }
+
+                if (node->is_value_initialized() && !node->input_edges().empty() && !node->output_edges().empty()) {
+                    if (filled) {
+                        file.write(" style=filled");
+                    }
+                } else {
+                    file.write(node->is_value_initialized() ? " style=\"bold" : " style=\"dashed");
+                    file.write(filled ? ",filled\"" : "\"");
+                }
+
+                if (node->is_dirty()) {
+                    file.write(" color=red");
+                }
+
+                file.write("];\n");
+
+                for (auto &input_edge : node->input_edges()) {
+                    AttributeID resolved_input = input_edge.attribute.resolve(TraversalOptions::None).attribute();
+                    if (!resolved_input.is_node()) {
+                        continue;
+                    }
+
+                    file.write("  _");
+                    file.write_uint(IAGAttribute(input_edge.attribute));
+                    file.write(" -> _");
+                    file.write_uint(IAGAttribute(attribute));
+                    file.write('[');
+
+                    // collect indirect nodes between the input and its source node
+                    AttributeID intermediate = input_edge.attribute;
+                    while (auto indirect_node = intermediate.get_indirect_node()) {
+                        indirect_nodes.insert(indirect_node, {});
+
+                        AttributeID source = indirect_node->source().identifier();
+                        if (source.is_node()) {
+                            break;
+                        }
+                        intermediate = source.resolve(TraversalOptions::SkipMutableReference).attribute();
+                    }
+
+                    if (input_edge.options & IAGInputOptionsChanged) {
+                        file.write(" color=red");
+                    }
+
+                    Subgraph *input_subgraph = resolved_input.subgraph();
+                    Subgraph *attribute_subgraph = attribute.subgraph();
+                    uint64_t input_context_id = input_subgraph ? input_subgraph->context_id() : 0;
+                    uint64_t attribute_context_id = attribute_subgraph ? attribute_subgraph->context_id() : 0;
+                    if (input_context_id != attribute_context_id) {
+                        file.write(" penwidth=2");
+                    }
+
+                    if (input_edge.attribute.is_node()) {
+                        uint32_t offset = input_edge.attribute.resolve(TraversalOptions::SkipMutableReference).offset();
+                        if (offset > 0) {
+                            file.write_format(" label=\"@%u\"", offset);
+                        }
+                    }
+
+                    file.write("];\n");
+                }
+            }
+        }
+    }
+
+    indirect_nodes.for_each([&file](data::ptr<IndirectNode> indirect_node, util::FlatNoValue) {
+        file.write_format("  _%u[label=\"%u\" shape=box];\n", indirect_node.offset(), indirect_node.offset());
+
+        OffsetAttributeID resolved_source =
+            indirect_node->source().identifier().resolve(TraversalOptions::SkipMutableReference);
+        file.write_format("  _%u -> _%u[label=\"@%u\"];\n", IAGAttribute(resolved_source.attribute()),
+                          indirect_node.offset(), resolved_source.offset());
+
+        if (indirect_node->is_mutable()) {
+            if (auto dependency = indirect_node->to_mutable().dependency()) {
+                file.write_format("  _%u -> _%u[color=blue];\n", IAGAttribute(dependency), indirect_node.offset());
+            }
+        }
+    });
+
+    file.write("}\n");
+
+    file.flush();
+    return !file.failed();
+}
+
+#pragma mark - Archiving
+
+#if !TARGET_OS_MAC
+void Graph::write_to_file(Graph *graph, const char *filename, bool exclude_values) {
+    if (filename == nullptr) {
+        filename = "graph.json";
+    }
+
+    char path[PATH_MAX];
+    if (*filename == '/') {
+        snprintf(path, sizeof(path), "%s", filename);
+    } else {
+        const char *temporary_directory = getenv("TMPDIR");
+        if (temporary_directory == nullptr || *temporary_directory == '\0') {
+            temporary_directory = "/tmp";
+        }
+        snprintf(path, sizeof(path), "%s/%s", temporary_directory, filename);
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        fprintf(stdout, "Unable to write to \"%s\": %s\n", path, strerror(errno));
+        return;
+    }
+
+    bool succeeded = export_json(graph, fd, !exclude_values, graph == nullptr);
+    int close_result = close(fd);
+    if (!succeeded || close_result != 0) {
+        fprintf(stdout, "Unable to write to \"%s\": %s\n", path, strerror(errno));
+        return;
+    }
+
+    fprintf(stdout, "Wrote graph data to \"%s\".\n", path);
+}
+#endif
+
+} // namespace IAG
@@ -0,0 +1,322 @@
+#include "Graph.h"
+
+#include <cstring>
+
+#include <Utilities/FlatTable.h>
+
+#include "Attribute/AttributeData/Node/Node.h"
+#include "Attribute/AttributeID/OffsetAttributeID.h"
+#include "Attribute/AttributeView/AttributeView.h"
+#include "ComputeCxx/IAGGraphSnapshot.h"
+#include "FileWriter.h"
+#include "KeyTable.h"
+#include "Subgraph/Subgraph.h"
+#include "Tree/TreeElement.h"
+
+namespace IAG {
+
+namespace {
+
+template <typename T> struct PointerHash {
+    uint64_t operator()(data::ptr<T> pointer) const noexcept { return util::mix_hash(pointer.offset()); }
+};
+
+constexpr uint64_t section_alignment = 8;
+
+uint64_t align_section_offset(uint64_t offset) { return (offset + section_alignment - 1) & ~(section_alignment - 1); }
+
+// Strings are stored NUL-terminated and referenced by their byte offset in the strings section.
+class StringTable {
+  private:
+    vector<char, 0, uint64_t> _bytes;
+
+  public:
+    uint32_t insert(const char *_Nullable string) {
+        if (string == nullptr) {
+            return IAG_GRAPH_SNAPSHOT_NO_INDEX;
+        }
+        uint32_t offset = uint32_t(_bytes.size());
+        for (const char *c = string; *c; ++c) {
+            _bytes.push_back(*c);
+        }
+        _bytes.push_back('\0');
+        return offset;
+    };
+
+    const vector<char, 0, uint64_t> &bytes() const { return _bytes; };
+};
+
+} // namespace
+
+#pragma mark - Snapshot
+
+// Writes the graph as a header followed by flat arrays of fixed size records, so the file can be mapped and queried
+// in place. Everything except the node, edge and tree records is gathered in a first pass; those are counted and
+// indexed in the first pass and streamed out in a second pass over the same pages.
+bool Graph::write_snapshot(int fd) {
+    StringTable strings;
+
+    // Types, indexed by type ID
+    auto types = vector<IAGGraphSnapshotType, 0, uint32_t>();
+    for (uint32_t type_id = 0; type_id < _types.size(); ++type_id) {
+        IAGGraphSnapshotType type_record = {};
+        if (auto &type = _types[type_id]) {
+            type_record.name = strings.insert(type->body_metadata().name(false));
+            type_record.value_name = strings.insert(type->value_metadata().name(false));
+            type_record.self_size = uint32_t(type->body_metadata().vw_size());
+            type_record.value_size = uint32_t(type->value_metadata().vw_size());
+            type_record.flags = uint32_t(type->flags());
+        } else {
+            type_record.name = IAG_GRAPH_SNAPSHOT_NO_INDEX;
+            type_record.value_name = IAG_GRAPH_SNAPSHOT_NO_INDEX;
+        }
+        types.push_back(type_record);
+    }
+
+    // Keys, indexed by key ID
+    auto keys = vector<IAGGraphSnapshotKey, 0, uint32_t>();
+    if (_keys) {
+        for (uint32_t key_id = 0; key_id < _keys->size(); ++key_id) {
+            keys.push_back({strings.insert(_keys->get(key_id))});
+        }
+    }
+
+    // Nodes are numbered in subgraph and page order, which the second pass repeats
+    auto node_indices = util::FlatTable<data::ptr<Node>, uint32_t, PointerHash<Node>>();
+    node_indices.reserve(_num_nodes);
+    uint32_t num_input_edges = 0;
+    uint32_t num_output_edges = 0;
+
+    auto subgraph_records = vector<IAGGraphSnapshotSubgraph, 0, uint32_t>();
+    for (auto subgraph : _subgraphs) {
+        IAGGraphSnapshotSubgraph subgraph_record = {};
+        subgraph_record.context_id = subgraph->context_id();
+        subgraph_record.id = uint32_t(subgraph->subgraph_id());
+        subgraph_record.invalid = !subgraph->is_valid();
+        subgraph_record.first_node = uint32_t(node_indices.count());
+
+        for (auto page : subgraph->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                if (auto node = attribute.get_node()) {
+                    node_indices.insert(node, uint32_t(node_indices.count()) + 1);
+                    num_input_edges += node->input_edges().size();
+                    num_output_edges += node->output_edges().size();
+                }
+            }
+        }
+
+        subgraph_record.node_count = uint32_t(node_indices.count()) - subgraph_record.first_node;
+        subgraph_records.push_back(subgraph_record);
+    }
+
+    auto node_index = [&node_indices](AttributeID attribute) -> uint32_t {
+        if (!attribute.is_node()) {
+            return IAG_GRAPH_SNAPSHOT_NO_INDEX;
+        }
+        uint32_t index = node_indices.lookup(attribute.get_node(), nullptr);
+        return index ? index - 1 : IAG_GRAPH_SNAPSHOT_NO_INDEX;
+    };
+
+    // Trees are numbered depth first from each subgraph's root, and the values of each tree are numbered
+    // consecutively so that a tree's values form a contiguous run
+    auto tree_indices = util::FlatTable<data::ptr<TreeElement>, uint32_t, PointerHash<TreeElement>>();
+    auto trees = vector<data::ptr<TreeElement>, 0, uint32_t>();
+    auto tree_type_names = vector<uint32_t, 0, uint32_t>();
+    auto tree_first_values = vector<uint32_t, 0, uint32_t>();
+    uint32_t num_tree_values = 0;
+
+    auto tree_stack = vector<data::ptr<TreeElement>, 0, uint64_t>();
+    for (auto subgraph : _subgraphs) {
+        if (data::ptr<TreeElement> tree_root = subgraph->tree_root()) {
+            tree_stack.push_back(tree_root);
+        }
+        while (!tree_stack.empty()) {
+            data::ptr<TreeElement> tree = tree_stack.back();
+            tree_stack.pop_back();
+            if (tree_indices.lookup(tree, nullptr) != 0) {
+                continue;
+            }
+
+            trees.push_back(tree);
+            tree_indices.insert(tree, trees.size());
+            tree_type_names.push_back(tree->type ? strings.insert(tree->type->name(false))
+                                                 : IAG_GRAPH_SNAPSHOT_NO_INDEX);
+
+            tree_first_values.push_back(tree->first_value ? num_tree_values : IAG_GRAPH_SNAPSHOT_NO_INDEX);
+            for (data::ptr<TreeValue> value = tree->first_value; value != nullptr; value = value->next) {
+                num_tree_values += 1;
+            }
+
+            if (tree->next_sibling) {
+                tree_stack.push_back(tree->next_sibling);
+            }
+            if (tree->first_child) {
+                tree_stack.push_back(tree->first_child);
+            }
+        }
+    }
+
+    auto tree_index = [&tree_indices](data::ptr<TreeElement> tree) -> uint32_t {
+        uint32_t index = tree ? tree_indices.lookup(tree, nullptr) : 0;
+        return index ? index - 1 : IAG_GRAPH_SNAPSHOT_NO_INDEX;
+    };
+    for (uint32_t subgraph_index = 0; subgraph_index < _subgraphs.size(); ++subgraph_index) {
+        subgraph_records[subgraph_index].tree_root = tree_index(_subgraphs[subgraph_index]->tree_root());
+    }
+
+    // Header
+    IAGGraphSnapshotHeader header = {};
+    memcpy(header.magic, IAG_GRAPH_SNAPSHOT_MAGIC, sizeof(IAG_GRAPH_SNAPSHOT_MAGIC));
+    header.version = IAG_GRAPH_SNAPSHOT_VERSION;
+    header.header_size = sizeof(IAGGraphSnapshotHeader);
+    header.graph_id = _id;
+
+    uint64_t offset = sizeof(IAGGraphSnapshotHeader);
+    auto add_section = [&header, &offset](IAGGraphSnapshotSectionKind kind, uint64_t count, uint32_t record_size) {
+        offset = align_section_offset(offset);
+        header.sections[kind] = {offset, uint32_t(count), record_size};
+        offset += count * record_size;
+    };
+    add_section(IAGGraphSnapshotSectionKindStrings, strings.bytes().size(), 1);
+    add_section(IAGGraphSnapshotSectionKindTypes, types.size(), sizeof(IAGGraphSnapshotType));
+    add_section(IAGGraphSnapshotSectionKindSubgraphs, subgraph_records.size(), sizeof(IAGGraphSnapshotSubgraph));
+    add_section(IAGGraphSnapshotSectionKindNodes, node_indices.count(), sizeof(IAGGraphSnapshotNode));
+    add_section(IAGGraphSnapshotSectionKindInputEdges, num_input_edges, sizeof(IAGGraphSnapshotInputEdge));
+    add_section(IAGGraphSnapshotSectionKindOutputEdges, num_output_edges, sizeof(IAGGraphSnapshotOutputEdge));
+    add_section(IAGGraphSnapshotSectionKindKeys, keys.size(), sizeof(IAGGraphSnapshotKey));
+    add_section(IAGGraphSnapshotSectionKindTrees, trees.size(), sizeof(IAGGraphSnapshotTree));
+    add_section(IAGGraphSnapshotSectionKindTreeValues, num_tree_values, sizeof(IAGGraphSnapshotTreeValue));
+    header.file_size = offset;
+
+    FileWriter file = FileWriter(fd);
+    uint64_t written = 0;
+    auto begin_section = [&header, &file, &written](IAGGraphSnapshotSectionKind kind) {
+        const IAGGraphSnapshotSection &section = header.sections[kind];
+        file.write_zeros(section.offset - written);
+        written = section.offset + uint64_t(section.count) * section.record_size;
+    };
+
+    file.write_record(header);
+    written = sizeof(IAGGraphSnapshotHeader);
+
+    begin_section(IAGGraphSnapshotSectionKindStrings);
+    file.write(strings.bytes().data(), strings.bytes().size());
+
+    begin_section(IAGGraphSnapshotSectionKindTypes);
+    for (auto &type_record : types) {
+        file.write_record(type_record);
+    }
+
+    begin_section(IAGGraphSnapshotSectionKindSubgraphs);
+    for (auto &subgraph_record : subgraph_records) {
+        file.write_record(subgraph_record);
+    }
+
+    begin_section(IAGGraphSnapshotSectionKindNodes);
+    uint32_t first_input_edge = 0;
+    uint32_t first_output_edge = 0;
+    for (uint32_t subgraph_index = 0; subgraph_index < _subgraphs.size(); ++subgraph_index) {
+        for (auto page : _subgraphs[subgraph_index]->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                auto node = attribute.get_node();
+                if (!node) {
+                    continue;
+                }
+
+                IAGGraphSnapshotNode node_record = {};
+                node_record.attribute = IAGAttribute(attribute);
+                node_record.type_id = node->type_id();
+                node_record.subgraph = subgraph_index;
+                node_record.state = node->flags();
+                node_record.subgraph_flags = node->subgraph_flags();
+                node_record.first_input_edge = first_input_edge;
+                node_record.input_edge_count = node->input_edges().size();
+                node_record.first_output_edge = first_output_edge;
+                node_record.output_edge_count = node->output_edges().size();
+                file.write_record(node_record);
+
+                first_input_edge += node_record.input_edge_count;
+                first_output_edge += node_record.output_edge_count;
+            }
+        }
+    }
+
+    begin_section(IAGGraphSnapshotSectionKindInputEdges);
+    for (auto subgraph : _subgraphs) {
+        for (auto page : subgraph->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                if (auto node = attribute.get_node()) {
+                    for (auto &input_edge : node->input_edges()) {
+                        OffsetAttributeID resolved = input_edge.attribute.resolve(TraversalOptions::None);
+                        IAGGraphSnapshotInputEdge input_edge_record = {};
+                        input_edge_record.attribute = IAGAttribute(input_edge.attribute);
+                        input_edge_record.node = node_index(resolved.attribute());
+                        input_edge_record.offset = resolved.offset();
+                        input_edge_record.options = input_edge.options;
+                        file.write_record(input_edge_record);
+                    }
+                }
+            }
+        }
+    }
+
+    begin_section(IAGGraphSnapshotSectionKindOutputEdges);
+    for (auto subgraph : _subgraphs) {
+        for (auto page : subgraph->pages()) {
+            for (auto attribute : attribute_view(page)) {
+                if (auto node = attribute.get_node()) {
+                    for (auto &output_edge : node->output_edges()) {
+                        IAGGraphSnapshotOutputEdge output_edge_record = {};
+                        output_edge_record.attribute = IAGAttribute(output_edge.attribute);
+                        output_edge_record.node = node_index(output_edge.attribute);
+                        file.write_record(output_edge_record);
+                    }
+                }
+            }
+        }
+    }
+
+    begin_section(IAGGraphSnapshotSectionKindKeys);
+    for (auto &key_record : keys) {
+        file.write_record(key_record);
+    }
+
+    begin_section(IAGGraphSnapshotSectionKindTrees);
+    for (uint32_t index = 0; index < trees.size(); ++index) {
+        data::ptr<TreeElement> tree = trees[index];
+
+        IAGGraphSnapshotTree tree_record = {};
+        tree_record.value = IAGAttribute(tree->value);
+        tree_record.node = tree->value ? node_index(tree->value.resolve(TraversalOptions::None).attribute())
+                                       : IAG_GRAPH_SNAPSHOT_NO_INDEX;
+        tree_record.type_name = tree_type_names[index];
+        tree_record.flags = tree->flags;
+        tree_record.parent = tree_index(tree->parent);
+        tree_record.first_child = tree_index(tree->first_child);
+        tree_record.next_sibling = tree_index(tree->next_sibling);
+        tree_record.first_value = tree_first_values[index];
+        file.write_record(tree_record);
+    }
+
+    begin_section(IAGGraphSnapshotSectionKindTreeValues);
+    uint32_t tree_value_index = 0;
+    for (auto tree : trees) {
+        for (data::ptr<TreeValue> value = tree->first_value; value != nullptr; value = value->next) {
+            OffsetAttributeID resolved = value->value.resolve(TraversalOptions::None);
+            tree_value_index += 1;
+
+            IAGGraphSnapshotTreeValue tree_value_record = {};
+            tree_value_record.key_id = value->key_id;
+            tree_value_record.value = IAGAttribute(value->value);
+            tree_value_record.node = node_index(resolved.attribute());
+            tree_value_record.offset = resolved.offset();
+            tree_value_record.next = value->next ? tree_value_index : IAG_GRAPH_SNAPSHOT_NO_INDEX;
+            file.write_record(tree_value_record);
+        }
+    }
+
+    file.flush();
+    return !file.failed();
+}
+
+} // namespace IAG
@@ -14,7 +14,9 @@
 #include "Attribute/AttributeData/Node/IndirectNode.h"
 #include "Attribute/AttributeID/OffsetAttributeID.h"
 #include "Context.h"
+#include "Data/Table.h"
 #include "Graph.h"
+#include "ProfileData.h"
 #include "Trace/ExternalTrace.h"
 #include "UpdateStack.h"
 
@@ -144,11 +146,41 @@ uint64_t IAGGraphGetCounter(IAGGraphRef graph, IAGGraphCounterQueryType query) {
         return graph_context->graph().num_subgraphs();
     case IAGGraphCounterQueryTypeCreatedSubgraphs:
         return graph_context->graph().num_subgraphs_total();
+    case IAGGraphCounterQueryTypeNodeCacheHits:
+        return graph_context->graph().node_cache_hits();
+    case IAGGraphCounterQueryTypeNodeCacheMisses:
+        return graph_context->graph().node_cache_misses();
+    case IAGGraphCounterQueryTypeNodeCacheEvictions:
+        return graph_context->graph().node_cache_evictions();
+    case IAGGraphCounterQueryTypeNodeCacheBytes:
+        return graph_context->graph().node_cache_bytes();
+    case IAGGraphCounterQueryTypeDataBytes:
+        return IAG::data::table::shared().bytes();
+    case IAGGraphCounterQueryTypeDataCachedBytes:
+        return IAG::data::table::shared().cached_bytes();
+    case IAGGraphCounterQueryTypeDataMappedBytes:
+        return IAG::data::table::shared().mapped_bytes();
+    case IAGGraphCounterQueryTypeRecycledAllocations:
+        return graph_context->graph().num_recycled_allocations();
+    case IAGGraphCounterQueryTypeRecycledBytes:
+        return graph_context->graph().num_recycled_bytes();
+    case IAGGraphCounterQueryTypeTraceEvents:
+        return uint64_t(graph_context->graph().trace_events());
+    case IAGGraphCounterQueryTypeIndirectResolutionHits:
+        return graph_context->graph().indirect_resolution_hits();
+    case IAGGraphCounterQueryTypeIndirectResolutionMisses:
+        return graph_context->graph().indirect_resolution_misses();
     default:
         return 0;
     }
 }
 
+#pragma mark - Data
+
+const void *IAGGraphGetVMRegionBaseAddress() {
+    return reinterpret_cast<const void *>(IAG::data::table::shared().vm_region_base_address());
+}
+
 #pragma mark - Main handler
 
 void IAGGraphWithMainThreadHandler(IAGGraphRef graph,
@@ -483,6 +515,57 @@ inline IAGChangedValue get_value(IAG::AttributeID attribute_id, uint32_t seed, I
     return {value, flags};
 }
 
+// Calls body with runs of the attributes that share a graph, so each run propagates in a single traversal. Each run
+// is traced as one event, named by event_name.
+template <typename T>
+    requires std::invocable<T, IAG::Graph &, std::span<const IAG::data::ptr<IAG::Node>>, size_t>
+void foreach_graph_run(const IAGAttribute *attributes, size_t count, const char *event_name, T body) {
+    auto nodes = IAG::vector<IAG::data::ptr<IAG::Node>, 16, uint64_t>();
+    IAG::Graph *graph = nullptr;
+    size_t run_start = 0;
+
+    auto flush_run = [&nodes, &graph, &run_start, &event_name, &body]() {
+        if (!graph || nodes.empty()) {
+            return;
+        }
+        uint32_t event_id = 0;
+        if (graph->has_trace_events(IAG::TraceEvents::Event)) {
+            event_id = graph->intern_key(event_name);
+        }
+        auto first_node = nodes.front();
+        graph->foreach_trace(IAG::TraceEvents::Event,
+                             [&first_node, &event_id](IAG::Trace &trace) { trace.begin_event(first_node, event_id); });
+
+        body(*graph, std::span<const IAG::data::ptr<IAG::Node>>(nodes.data(), nodes.size()), run_start);
+
+        graph->foreach_trace(IAG::TraceEvents::Event,
+                             [&first_node, &event_id](IAG::Trace &trace) { trace.end_event(first_node, event_id); });
+        nodes.clear();
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        auto attribute_id = IAG::AttributeID(attributes[i]);
+        auto node = attribute_id.get_node();
+        if (!node) {
+            IAG::precondition_failure("non-direct attribute id: %u", attributes[i]);
+        }
+        attribute_id.validate_data_offset();
+
+        auto subgraph = attribute_id.subgraph();
+        if (!subgraph) {
+            IAG::precondition_failure("no graph: %u", attributes[i]);
+        }
+
+        if (subgraph->graph() != graph) {
+            flush_run();
+            graph = subgraph->graph();
+            run_start = i;
+        }
+        nodes.push_back(node);
+    }
+    flush_run();
+}
+
 } // namespace
 
 IAGChangedValue IAGGraphGetValue(IAGAttribute attribute, IAGValueOptions options, IAGTypeID type) {
@@ -546,6 +629,19 @@ bool IAGGraphSetValue(IAGAttribute attribute, const void *value, IAGTypeID type)
     return subgraph->graph()->value_set(attribute_id.get_node(), *metadata, value);
 }
 
+uint64_t IAGGraphSetValues(const IAGAttribute *attributes, const void *const *values, const IAGTypeID *types,
+                           size_t count) {
+    auto metadatas = reinterpret_cast<const IAG::swift::metadata *const *>(types);
+    uint64_t changed_count = 0;
+    foreach_graph_run(attributes, count, "set_values",
+                      [&metadatas, &values, &changed_count](IAG::Graph &graph,
+                                                            std::span<const IAG::data::ptr<IAG::Node>> nodes,
+                                                            size_t run_start) {
+                          changed_count += graph.value_set(nodes, metadatas + run_start, values + run_start);
+                      });
+    return changed_count;
+}
+
 bool IAGGraphHasValue(IAGAttribute attribute) {
     auto attribute_id = IAG::AttributeID(attribute);
     auto node = attribute_id.get_node();
@@ -626,6 +722,13 @@ void IAGGraphInvalidateValue(IAGAttribute attribute) {
     subgraph->graph()->value_mark(node);
 }
 
+void IAGGraphInvalidateValues(const IAGAttribute *attributes, size_t count) {
+    foreach_graph_run(attributes, count, "invalidate_values",
+                      [](IAG::Graph &graph, std::span<const IAG::data::ptr<IAG::Node>> nodes, size_t run_start) {
+                          graph.value_mark(nodes);
+                      });
+}
+
 void IAGGraphInvalidateAllValues(IAGGraphRef graph) {
     auto graph_context = IAG::Graph::Context::from_cf(graph);
     graph_context->graph().value_mark_all();
@@ -717,6 +820,16 @@ void *IAGGraphReadCachedAttributeIfExists(size_t hash, IAGTypeID type, const voi
     return value;
 }
 
+uint64_t IAGGraphGetNodeCacheBudget(IAGGraphRef graph) {
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    return graph_context->graph().node_cache_budget();
+}
+
+void IAGGraphSetNodeCacheBudget(IAGGraphRef graph, uint64_t budget) {
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    graph_context->graph().set_node_cache_budget(budget);
+}
+
 #pragma mark - Update
 
 void IAGGraphSetUpdate(const void *update) {
@@ -1005,9 +1118,11 @@ void IAGGraphPrepareTrace(IAGGraphRef graph, const IAGTraceTypeRef trace, void *
 
 void IAGGraphAddTraceEvent(IAGGraphRef graph, const char *event_name, const void *value, IAGTypeID type) {
     auto graph_context = IAG::Graph::Context::from_cf(graph);
-    graph_context->graph().foreach_trace([&graph_context, &event_name, &value, &type](IAG::Trace &trace) {
-        trace.custom_event(*graph_context, event_name, value, *reinterpret_cast<const IAG::swift::metadata *>(type));
-    });
+    graph_context->graph().foreach_trace(
+        IAG::TraceEvents::Custom, [&graph_context, &event_name, &value, &type](IAG::Trace &trace) {
+            trace.custom_event(*graph_context, event_name, value,
+                               *reinterpret_cast<const IAG::swift::metadata *>(type));
+        });
 }
 
 bool IAGGraphTraceEventEnabled(IAGGraphRef graph, uint32_t event_id) {
@@ -1075,17 +1190,78 @@ void IAGGraphAddNamedTraceEvent(IAGGraphRef graph, IAGNamedTraceEventID event_id
                                 const uint32_t *event_args, CFDataRef data, IAGNamedTraceEventFlags flags) {
     auto graph_context = IAG::Graph::Context::from_cf(graph);
     graph_context->graph().foreach_trace(
+        IAG::TraceEvents::Named,
         [&graph_context, &event_id, &event_arg_count, &event_args, &data, &flags](IAG::Trace &trace) {
             trace.named_event(*graph_context, event_id, event_arg_count, event_args, data, flags);
         });
 }
 
-// MARK: Description
+#pragma mark - Profile
+
+void IAGGraphStartProfiling(IAGGraphRef graph) {
+    if (graph == nullptr) {
+        IAG::Graph::all_start_profiling();
+        return;
+    }
+
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    graph_context->graph().start_profiling();
+}
+
+void IAGGraphStopProfiling(IAGGraphRef graph) {
+    if (graph == nullptr) {
+        IAG::Graph::all_stop_profiling();
+        return;
+    }
+
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    graph_context->graph().stop_profiling();
+}
+
+void IAGGraphResetProfile(IAGGraphRef graph) {
+    if (graph == nullptr) {
+        IAG::Graph::all_reset_profile();
+        return;
+    }
+
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    graph_context->graph().reset_profile();
+}
+
+size_t IAGGraphCopyProfileData(IAGGraphRef graph, IAGProfileEntry *entries, size_t capacity) {
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    auto profile_data = graph_context->graph().profile_data();
+    if (profile_data == nullptr) {
+        return 0;
+    }
+    return profile_data->copy_entries(entries, capacity);
+}
+
+#pragma mark - Description
+
+bool IAGGraphExportJSON(IAGGraphRef graph, int fd, IAGGraphExportOptions options) {
+    bool include_values = options & IAGGraphExportOptionsIncludeValues;
+    if (graph == nullptr) {
+        return IAG::Graph::export_json(nullptr, fd, include_values, true);
+    }
+
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    return IAG::Graph::export_json(&graph_context->graph(), fd, include_values,
+                                   options & IAGGraphExportOptionsAllGraphs);
+}
+
+bool IAGGraphExportDot(IAGGraphRef graph, int fd, IAGGraphExportOptions options) {
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    return graph_context->graph().export_dot(fd, options & IAGGraphExportOptionsIncludeValues);
+}
+
+bool IAGGraphWriteSnapshot(IAGGraphRef graph, int fd) {
+    auto graph_context = IAG::Graph::Context::from_cf(graph);
+    return graph_context->graph().write_snapshot(fd);
+}
 
-#if TARGET_OS_MAC
 void IAGGraphArchiveJSON(const char *filename) { IAG::Graph::write_to_file(nullptr, filename, false); }
 
 void IAGGraphArchiveJSON2(const char *filename, bool exclude_values) {
     IAG::Graph::write_to_file(nullptr, filename, exclude_values);
 }
-#endif
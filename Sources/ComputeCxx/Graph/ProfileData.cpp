@@ -0,0 +1,78 @@
+#include "ProfileData.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "Subgraph/Subgraph.h"
+
+namespace IAG {
+
+uint32_t Graph::ProfileData::entry_index(uint32_t type_id, uint32_t subgraph_id) {
+    uint64_t key = entry_key(type_id, subgraph_id);
+    uint32_t index = _entry_indices.lookup(key, nullptr);
+    if (index == 0) {
+        _entries.push_back({type_id, subgraph_id, 0, 0, 0, {}});
+        index = _entries.size();
+        _entry_indices.insert(key, index);
+    }
+    return index;
+}
+
+void Graph::ProfileData::record_update(uint32_t type_id, uint32_t subgraph_id, uint64_t duration) {
+    IAGProfileEntry &entry = _entries[entry_index(type_id, subgraph_id) - 1];
+    entry.update_count += 1;
+    entry.total_duration += duration;
+    entry.max_duration = std::max(entry.max_duration, duration);
+
+    uint32_t bucket = std::min(uint32_t(std::bit_width(duration)), uint32_t(IAG_PROFILE_HISTOGRAM_BUCKET_COUNT - 1));
+    entry.histogram[bucket] += 1;
+}
+
+void Graph::ProfileData::remove_node(data::ptr<Node> node, uint32_t type_id) {
+    uint32_t subgraph_id = uint32_t(AttributeID(node).subgraph()->subgraph_id());
+    if (subgraph_id == 0) {
+        return;
+    }
+
+    // The first node of each type removed from a subgraph merges the entry, later nodes find nothing to merge
+    uint64_t key = entry_key(type_id, subgraph_id);
+    uint32_t index = _entry_indices.lookup(key, nullptr);
+    if (index == 0) {
+        return;
+    }
+
+    uint32_t merged_index = entry_index(type_id, 0);
+    IAGProfileEntry &removed = _entries[index - 1];
+    IAGProfileEntry &merged = _entries[merged_index - 1];
+    merged.update_count += removed.update_count;
+    merged.total_duration += removed.total_duration;
+    merged.max_duration = std::max(merged.max_duration, removed.max_duration);
+    for (uint32_t bucket = 0; bucket < IAG_PROFILE_HISTOGRAM_BUCKET_COUNT; ++bucket) {
+        merged.histogram[bucket] += removed.histogram[bucket];
+    }
+
+    // Move the last entry into the removed entry's position
+    _entry_indices.remove(key);
+    uint32_t last_index = _entries.size();
+    if (index != last_index) {
+        IAGProfileEntry &moved = _entries[index - 1];
+        moved = _entries[last_index - 1];
+        _entry_indices.insert(entry_key(moved.type_id, moved.subgraph_id), index);
+    }
+    _entries.pop_back();
+}
+
+void Graph::ProfileData::reset() {
+    _entries.clear();
+    _entry_indices.remove_if([](uint64_t, uint32_t) { return true; });
+}
+
+size_t Graph::ProfileData::copy_entries(IAGProfileEntry *entries, size_t capacity) const {
+    if (entries) {
+        size_t count = std::min(capacity, size_t(_entries.size()));
+        std::copy(_entries.begin(), _entries.begin() + count, entries);
+    }
+    return _entries.size();
+}
+
+} // namespace IAG
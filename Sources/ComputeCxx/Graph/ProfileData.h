@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Utilities/FlatTable.h>
+
+#include "ComputeCxx/IAGBase.h"
+#include "ComputeCxx/IAGProfileEntry.h"
+#include "Graph.h"
+
+IAG_ASSUME_NONNULL_BEGIN
+
+namespace IAG {
+
+/// Update counts and durations, keyed by attribute type and subgraph.
+///
+/// When the nodes of a subgraph are removed, its entries are merged into the entry for their type with a subgraph id of
+/// zero, so the number of entries is bounded by the live subgraphs rather than every subgraph that was ever profiled.
+///
+/// Durations are in the units of platform_absolute_time() and include the time spent updating attributes that were
+/// read from inside the update. Histogram bucket i counts updates whose duration has a bit width of i.
+class Graph::ProfileData {
+  private:
+    vector<IAGProfileEntry, 0, uint32_t> _entries;
+
+    // index of each entry plus one, keyed by subgraph id in the high bits and type id in the low bits
+    util::FlatTable<uint64_t, uint32_t> _entry_indices;
+
+    static uint64_t entry_key(uint32_t type_id, uint32_t subgraph_id) {
+        return (uint64_t(subgraph_id) << 32) | type_id;
+    };
+    uint32_t entry_index(uint32_t type_id, uint32_t subgraph_id);
+
+  public:
+    void record_update(uint32_t type_id, uint32_t subgraph_id, uint64_t duration);
+    void remove_node(data::ptr<Node> node, uint32_t type_id);
+    void reset();
+
+    uint32_t size() const { return _entries.size(); };
+    size_t copy_entries(IAGProfileEntry *_Nullable entries, size_t capacity) const;
+};
+
+} // namespace IAG
+
+IAG_ASSUME_NONNULL_END
@@ -11,6 +11,8 @@
 #include <ptrauth.h>
 #include <ranges>
 
+#include <platform/time.h>
+
 #include "Attribute/AttributeData/Node/IndirectNode.h"
 #include "Attribute/AttributeType/AttributeType.h"
 #include "ComputeCxx/IAGGraph.h"
@@ -44,6 +46,22 @@ Graph::TraceRecorder::TraceRecorder(Graph &graph, IAGGraphTraceFlags trace_flags
         _named_event_subsystems.push_back(std::unique_ptr<const char, util::free_deleter>(strdup(subsystem)));
     }
 
+    // Custom traces only record profile marks, custom and named events, and the remaining events are only recorded in
+    // full traces. Compare failures are not recorded.
+    if (_trace_flags & IAGGraphTraceFlagsCustom) {
+        _events = TraceEvents::Profile | TraceEvents::Custom | TraceEvents::Named | TraceEvents::Log;
+    } else if (!(_trace_flags & IAGGraphTraceFlagsFull)) {
+        _events = TraceEvents::All & ~(TraceEvents::Invalidation | TraceEvents::Modify | TraceEvents::NeedsUpdate |
+                                       TraceEvents::EdgePending | TraceEvents::Dirty | TraceEvents::Pending |
+                                       TraceEvents::Value | TraceEvents::CompareFailed);
+    } else {
+        _events = TraceEvents::All & ~TraceEvents::CompareFailed;
+    }
+
+    if (_trace_flags & IAGGraphTraceFlagsCompact) {
+        encode_format();
+    }
+
     #if TARGET_OS_MAC
     void *array[1] = {(void *)&IAGGraphCreate};
     image_offset image_offsets[1];
@@ -53,15 +71,15 @@ Graph::TraceRecorder::TraceRecorder(Graph &graph, IAGGraphTraceFlags trace_flags
     #endif
 }
 
-Graph::TraceRecorder::~TraceRecorder() { _encoder.flush(); }
+Graph::TraceRecorder::~TraceRecorder() {
+    _encoder.flush();
+    _writer.reset();
+}
 
 #pragma mark - Encoder::Delegate
 
 int Graph::TraceRecorder::flush_encoder(Encoder &encoder) {
-    int fd = -1;
-    if (_trace_path_created) {
-        fd = open(_trace_path.get(), O_WRONLY | O_APPEND, 0666);
-    } else {
+    if (!_trace_path_created) {
         _trace_path_created = true;
 
         const char *trace_file = getenv("IAG_TRACE_FILE");
@@ -76,6 +94,7 @@ int Graph::TraceRecorder::flush_encoder(Encoder &encoder) {
 
         const char *separator = dir[strlen(dir) - 1] == '/' ? "" : "/";
 
+        int fd = -1;
         char *attempted_trace_path = nullptr;
         for (int attempt = 1; attempt <= 999; ++attempt) {
             asprintf(&attempted_trace_path, "%s%s%s-%04d.iag-trace", dir, separator, trace_file, attempt);
@@ -100,27 +119,28 @@ int Graph::TraceRecorder::flush_encoder(Encoder &encoder) {
         } else {
             fprintf(stdout, "failed to create trace file: %s%s%s-XXXX.ag-trace\n", dir, separator, trace_file);
         }
+
+        if (fd != -1) {
+            // the file stays open for the lifetime of the recorder
+            static bool async_trace_writes = []() {
+                char *result = getenv("IAG_ASYNC_TRACE_WRITES");
+                if (result) {
+                    return atoi(result) != 0;
+                }
+                return true;
+            }();
+
+            bool compressed = _trace_flags & IAGGraphTraceFlagsCompressed;
+            _writer = std::make_unique<TraceWriter>(fd, _trace_path.get(), compressed, async_trace_writes);
+        }
     }
-    if (fd == -1) {
+    if (!_writer) {
         return -1;
     }
 
-    const char *buffer = encoder.buffer().data();
-    size_t remaining = encoder.buffer().size();
-    while (remaining > 0) {
-        ssize_t written = write(fd, buffer, remaining);
-        if (written < 0) {
-            if (errno == EINTR) {
-                // try again on interrupted error
-                continue;
-            }
-            unlink(_trace_path.get());
-            break;
-        }
-        buffer += written;
-        remaining -= written;
-    }
-    return close(fd);
+    // Hand the encoded bytes to the writer thread, the encoder continues with a recycled buffer
+    _writer->submit(encoder.buffer());
+    return 0;
 }
 
 #pragma mark - Top level fields
@@ -131,10 +151,19 @@ int Graph::TraceRecorder::flush_encoder(Encoder &encoder) {
 #define MESSAGE_FIELD_KEYS 4
 #define MESSAGE_FIELD_STACK 5
 #define MESSAGE_FIELD_NAMED_EVENT 6
+#define MESSAGE_FIELD_FORMAT 7
 
-void Graph::TraceRecorder::encode_event_begin() { _encoder.encode_field_begin(MESSAGE_FIELD_EVENT); };
+// Compact events are top-level fields numbered from this base plus their event type, rather than event messages
+// starting with an event type field
+#define MESSAGE_FIELD_COMPACT_EVENT 64
 
-void Graph::TraceRecorder::encode_event_end() { _encoder.encode_field_end(); };
+#define FORMAT_VERSION_COMPACT 2
+
+void Graph::TraceRecorder::encode_format() {
+    _encoder.encode_field_begin(MESSAGE_FIELD_FORMAT);
+    _encoder.encode_field_varint(1, FORMAT_VERSION_COMPACT);
+    _encoder.encode_field_end();
+}
 
 void Graph::TraceRecorder::encode_subgraph(const IAG::Subgraph &subgraph) {
     _encoder.encode_field_begin(MESSAGE_FIELD_SUBGRAPH);
@@ -220,8 +249,7 @@ void Graph::TraceRecorder::encode_snapshot() {
     encode_types();
     encode_keys();
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginSnapshot);
+    encode_event_begin(EventType::BeginSnapshot);
     field_timestamp(_encoder);
     encode_event_end();
 
@@ -233,8 +261,7 @@ void Graph::TraceRecorder::encode_snapshot() {
 
     encode_stack();
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndSnapshot);
+    encode_event_begin(EventType::EndSnapshot);
     field_timestamp(_encoder);
     encode_event_end();
 }
@@ -251,12 +278,34 @@ void Graph::TraceRecorder::encode_snapshot() {
 #define EVENT_FIELD_BACKTRACE 8
 #define EVENT_FIELD_DATA 9
 #define EVENT_FIELD_NAMED_EVENT_ID 10
+#define EVENT_FIELD_TIMESTAMP_DELTA 11
+#define EVENT_FIELD_PAYLOAD_1_DELTA 12
+
+void Graph::TraceRecorder::encode_event_begin(EventType event_type) {
+    if (_trace_flags & IAGGraphTraceFlagsCompact) {
+        _encoder.encode_field_begin(MESSAGE_FIELD_COMPACT_EVENT + static_cast<uint64_t>(event_type));
+        return;
+    }
+
+    _encoder.encode_field_begin(MESSAGE_FIELD_EVENT);
+    field_event_type(_encoder, event_type);
+}
+
+void Graph::TraceRecorder::encode_event_end() { _encoder.encode_field_end(); };
 
 void Graph::TraceRecorder::field_event_type(Encoder &encoder, EventType event_type) {
     encoder.encode_field_varint(EVENT_FIELD_EVENT_TYPE, static_cast<uint64_t>(event_type));
 }
 
 void Graph::TraceRecorder::field_timestamp(Encoder &encoder) {
+    if (_trace_flags & IAGGraphTraceFlagsCompact) {
+        // nanoseconds of the monotonic clock since the previous timestamp, so readers needn't know the timebase
+        uint64_t timestamp = absolute_time_to_nanoseconds(platform_absolute_time());
+        encoder.encode_field_varint(EVENT_FIELD_TIMESTAMP_DELTA, timestamp - _last_timestamp);
+        _last_timestamp = timestamp;
+        return;
+    }
+
     auto timestamp = current_time();
     encoder.encode_field_varint(EVENT_FIELD_TIMESTAMP, static_cast<uint64_t>(timestamp));
 }
@@ -265,6 +314,18 @@ void Graph::TraceRecorder::field_payload_1(Encoder &encoder, uint64_t payload) {
     encoder.encode_field_varint(EVENT_FIELD_PAYLOAD_1, payload);
 }
 
+void Graph::TraceRecorder::field_attribute_payload_1(Encoder &encoder, uint32_t attribute) {
+    if (_trace_flags & IAGGraphTraceFlagsCompact) {
+        // zigzag encoded difference from the previous attribute, consecutive events usually name nearby attributes
+        int64_t delta = int64_t(attribute) - int64_t(_last_attribute);
+        encoder.encode_field_varint(EVENT_FIELD_PAYLOAD_1_DELTA, uint64_t(delta) << 1 ^ uint64_t(delta >> 63));
+        _last_attribute = attribute;
+        return;
+    }
+
+    encoder.encode_field_varint(EVENT_FIELD_PAYLOAD_1, attribute);
+}
+
 void Graph::TraceRecorder::field_payload_2(Encoder &encoder, uint64_t payload) {
     encoder.encode_field_varint(EVENT_FIELD_PAYLOAD_2, payload);
 }
@@ -373,15 +434,13 @@ void Graph::TraceRecorder::graph_destroyed() { delete this; };
 void Graph::TraceRecorder::trace_removed() { delete this; };
 
 void Graph::TraceRecorder::begin_trace(const Graph &graph) {
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginTrace);
+    encode_event_begin(EventType::BeginTrace);
     field_timestamp(_encoder);
     encode_event_end();
 }
 
 void Graph::TraceRecorder::end_trace(const Graph &graph) {
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndTrace);
+    encode_event_begin(EventType::EndTrace);
     field_timestamp(_encoder);
     encode_event_end();
 
@@ -391,6 +450,9 @@ void Graph::TraceRecorder::end_trace(const Graph &graph) {
 void Graph::TraceRecorder::sync_trace() {
     encode_snapshot();
     _encoder.flush();
+    if (_writer) {
+        _writer->sync();
+    }
 }
 
 void Graph::TraceRecorder::log_message_v(const char *format, va_list args) {
@@ -400,8 +462,7 @@ void Graph::TraceRecorder::log_message_v(const char *format, va_list args) {
         precondition_failure("vasprintf failure (%u)", errno);
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::LogMessage);
+    encode_event_begin(EventType::LogMessage);
     field_timestamp(_encoder);
     field_backtrace(_encoder);
     field_data(_encoder, message, strlen(message));
@@ -419,8 +480,7 @@ void Graph::TraceRecorder::begin_update(const Subgraph &subgraph, IAGAttributeFl
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginSubgraphUpdate);
+    encode_event_begin(EventType::BeginSubgraphUpdate);
     field_timestamp(_encoder);
     field_payload_1(_encoder, subgraph.subgraph_id());
     field_payload_2(_encoder, subgraph_flags);
@@ -433,8 +493,7 @@ void Graph::TraceRecorder::end_update(const Subgraph &subgraph) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndSubgraphUpdate);
+    encode_event_begin(EventType::EndSubgraphUpdate);
     field_timestamp(_encoder);
     field_payload_1(_encoder, subgraph.subgraph_id());
     field_backtrace(_encoder);
@@ -447,10 +506,9 @@ void Graph::TraceRecorder::begin_update(const Graph::UpdateStack &update_stack,
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginNodeUpdate);
+    encode_event_begin(EventType::BeginNodeUpdate);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, node.offset());
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, options);
     field_backtrace(_encoder);
     encode_event_end();
@@ -462,10 +520,9 @@ void Graph::TraceRecorder::end_update(const Graph::UpdateStack &update_stack, da
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndNodeUpdate);
+    encode_event_begin(EventType::EndNodeUpdate);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, node.offset());
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, update_status);
     field_backtrace(_encoder);
     encode_event_end();
@@ -476,10 +533,9 @@ void Graph::TraceRecorder::begin_update(data::ptr<Node> node) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginValueUpdate);
+    encode_event_begin(EventType::BeginValueUpdate);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, node.offset());
+    field_attribute_payload_1(_encoder, node.offset());
     field_backtrace(_encoder);
     encode_event_end();
 }
@@ -489,10 +545,9 @@ void Graph::TraceRecorder::end_update(data::ptr<Node> node, bool changed) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndValueUpdate);
+    encode_event_begin(EventType::EndValueUpdate);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, node.offset());
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, changed ? 1 : 0);
     field_backtrace(_encoder);
     encode_event_end();
@@ -503,8 +558,7 @@ void Graph::TraceRecorder::begin_update(const Graph::Context &context) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginGraphUpdate);
+    encode_event_begin(EventType::BeginGraphUpdate);
     field_timestamp(_encoder);
     field_payload_1(_encoder, context.id());
     field_backtrace(_encoder);
@@ -516,8 +570,7 @@ void Graph::TraceRecorder::end_update(const Graph::Context &context) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndGraphUpdate);
+    encode_event_begin(EventType::EndGraphUpdate);
     field_timestamp(_encoder);
     field_payload_1(_encoder, context.id());
     field_backtrace(_encoder);
@@ -532,10 +585,9 @@ void Graph::TraceRecorder::begin_invalidation(const Graph::Context &context, Att
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginGraphInvalidation);
+    encode_event_begin(EventType::BeginGraphInvalidation);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, attribute);
+    field_attribute_payload_1(_encoder, attribute);
     field_payload_2(_encoder, context.id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -549,10 +601,9 @@ void Graph::TraceRecorder::end_invalidation(const Graph::Context &context, Attri
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndGraphInvalidation);
+    encode_event_begin(EventType::EndGraphInvalidation);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, attribute);
+    field_attribute_payload_1(_encoder, attribute);
     field_payload_2(_encoder, context.id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -566,10 +617,9 @@ void Graph::TraceRecorder::begin_modify(data::ptr<Node> node) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginModifyNode);
+    encode_event_begin(EventType::BeginModifyNode);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, node.offset());
+    field_attribute_payload_1(_encoder, node.offset());
     field_backtrace(_encoder);
     encode_event_end();
 }
@@ -582,8 +632,7 @@ void Graph::TraceRecorder::end_modify(data::ptr<Node> node) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndModifyNode);
+    encode_event_begin(EventType::EndModifyNode);
     field_timestamp(_encoder);
     if (node.offset()) {
         field_payload_1(_encoder, 1);
@@ -597,10 +646,9 @@ void Graph::TraceRecorder::begin_event(data::ptr<Node> node, uint32_t event_id)
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::BeginEvent);
+    encode_event_begin(EventType::BeginEvent);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, node.offset());
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, event_id);
     field_backtrace(_encoder);
     encode_event_end();
@@ -611,10 +659,9 @@ void Graph::TraceRecorder::end_event(data::ptr<Node> node, uint32_t event_id) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::EndEvent);
+    encode_event_begin(EventType::EndEvent);
     field_timestamp(_encoder);
-    field_payload_1(_encoder, node.offset());
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, event_id);
     field_backtrace(_encoder);
     encode_event_end();
@@ -625,8 +672,7 @@ void Graph::TraceRecorder::created(const Graph::Context &context) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::GraphCreated);
+    encode_event_begin(EventType::GraphCreated);
     field_payload_1(_encoder, context.id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -637,8 +683,7 @@ void Graph::TraceRecorder::destroy(const Graph::Context &context) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::GraphDestroy);
+    encode_event_begin(EventType::GraphDestroy);
     field_payload_1(_encoder, context.id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -652,8 +697,7 @@ void Graph::TraceRecorder::needs_update(const Graph::Context &context) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::GraphNeedsUpdate);
+    encode_event_begin(EventType::GraphNeedsUpdate);
     field_payload_1(_encoder, context.id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -664,8 +708,7 @@ void Graph::TraceRecorder::created(const Subgraph &subgraph) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::SubgraphCreated);
+    encode_event_begin(EventType::SubgraphCreated);
     field_payload_1(_encoder, subgraph.subgraph_id());
     field_payload_2(_encoder, subgraph.context_id());
     field_backtrace(_encoder);
@@ -677,8 +720,7 @@ void Graph::TraceRecorder::invalidate(const Subgraph &subgraph) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::SubgraphInvalidate);
+    encode_event_begin(EventType::SubgraphInvalidate);
     field_payload_1(_encoder, subgraph.subgraph_id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -691,8 +733,7 @@ void Graph::TraceRecorder::destroy(const Subgraph &subgraph) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::SubgraphDestroy);
+    encode_event_begin(EventType::SubgraphDestroy);
     field_payload_1(_encoder, subgraph.subgraph_id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -703,8 +744,7 @@ void Graph::TraceRecorder::add_child(const Subgraph &subgraph, const Subgraph &c
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::SubgraphAddChild);
+    encode_event_begin(EventType::SubgraphAddChild);
     field_payload_1(_encoder, subgraph.subgraph_id());
     field_payload_2(_encoder, child.subgraph_id());
     field_backtrace(_encoder);
@@ -716,8 +756,7 @@ void Graph::TraceRecorder::remove_child(const Subgraph &subgraph, const Subgraph
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::SubgraphRemoveChild);
+    encode_event_begin(EventType::SubgraphRemoveChild);
     field_payload_1(_encoder, subgraph.subgraph_id());
     field_payload_2(_encoder, child.subgraph_id());
     field_backtrace(_encoder);
@@ -729,9 +768,8 @@ void Graph::TraceRecorder::added(data::ptr<Node> node) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeAdded);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeAdded);
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, AttributeID(node).subgraph()->subgraph_id());
     field_payload_3(_encoder, node->type_id());
     field_backtrace(_encoder);
@@ -743,9 +781,8 @@ void Graph::TraceRecorder::add_edge(data::ptr<Node> node, AttributeID input, IAG
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeAddEdge);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeAddEdge);
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, input);
     field_backtrace(_encoder);
     encode_event_end();
@@ -756,9 +793,8 @@ void Graph::TraceRecorder::remove_edge(data::ptr<Node> node, uint32_t input_inde
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeRemoveEdge);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeRemoveEdge);
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, node->input_edges()[input_index].attribute);
     field_backtrace(_encoder);
     encode_event_end();
@@ -772,9 +808,8 @@ void Graph::TraceRecorder::set_edge_pending(data::ptr<Node> node, uint32_t input
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeSetEdgePending);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeSetEdgePending);
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, node->input_edges()[input_index].attribute);
     field_payload_3(_encoder, pending ? 1 : 0);
     field_backtrace(_encoder);
@@ -789,9 +824,8 @@ void Graph::TraceRecorder::set_dirty(data::ptr<Node> node, bool dirty) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeSetDirty);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeSetDirty);
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, dirty ? 1 : 0);
     field_backtrace(_encoder);
     encode_event_end();
@@ -805,9 +839,8 @@ void Graph::TraceRecorder::set_pending(data::ptr<Node> node, bool pending) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeSetPending);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeSetPending);
+    field_attribute_payload_1(_encoder, node.offset());
     field_payload_2(_encoder, pending ? 1 : 0);
     field_backtrace(_encoder);
     encode_event_end();
@@ -821,9 +854,8 @@ void Graph::TraceRecorder::set_value(data::ptr<Node> node, const void *value) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeSetValue);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeSetValue);
+    field_attribute_payload_1(_encoder, node.offset());
     field_backtrace(_encoder);
     encode_event_end();
 }
@@ -836,9 +868,8 @@ void Graph::TraceRecorder::mark_value(data::ptr<Node> node) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NodeMarkValue);
-    field_payload_1(_encoder, node.offset());
+    encode_event_begin(EventType::NodeMarkValue);
+    field_attribute_payload_1(_encoder, node.offset());
     field_backtrace(_encoder);
     encode_event_end();
 }
@@ -848,9 +879,8 @@ void Graph::TraceRecorder::added(data::ptr<IndirectNode> indirect_node) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::IndirectNodeAdded);
-    field_payload_1(_encoder, indirect_node.offset());
+    encode_event_begin(EventType::IndirectNodeAdded);
+    field_attribute_payload_1(_encoder, indirect_node.offset());
     field_payload_2(_encoder, AttributeID(indirect_node).subgraph()->subgraph_id());
     field_backtrace(_encoder);
     encode_event_end();
@@ -861,9 +891,8 @@ void Graph::TraceRecorder::set_source(data::ptr<IndirectNode> indirect_node, Att
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::IndirectNodeSetSource);
-    field_payload_1(_encoder, indirect_node.offset());
+    encode_event_begin(EventType::IndirectNodeSetSource);
+    field_attribute_payload_1(_encoder, indirect_node.offset());
     // FIXME: This shadows param or is there no param>
     field_payload_2(_encoder, indirect_node->source().identifier()); // TODO: identifier()?
     field_payload_3(_encoder, AttributeID(source).subgraph()->subgraph_id());
@@ -876,9 +905,8 @@ void Graph::TraceRecorder::set_dependency(data::ptr<IndirectNode> indirect_node,
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::IndirectNodeSetDependency);
-    field_payload_1(_encoder, indirect_node.offset());
+    encode_event_begin(EventType::IndirectNodeSetDependency);
+    field_attribute_payload_1(_encoder, indirect_node.offset());
     // FIXME: This shadows param or is there no param>
     field_payload_2(_encoder, indirect_node->to_mutable().dependency());
     field_backtrace(_encoder);
@@ -890,8 +918,7 @@ void Graph::TraceRecorder::set_deadline(uint64_t deadline) {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::SetDeadline);
+    encode_event_begin(EventType::SetDeadline);
     field_timestamp(_encoder);
     field_payload_1(_encoder, deadline & 0xffffffff);
     field_payload_2(_encoder, deadline >> 32);
@@ -904,8 +931,7 @@ void Graph::TraceRecorder::passed_deadline() {
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::PassedDeadline);
+    encode_event_begin(EventType::PassedDeadline);
     field_timestamp(_encoder);
     field_backtrace(_encoder);
     encode_event_end();
@@ -914,8 +940,7 @@ void Graph::TraceRecorder::passed_deadline() {
 }
 
 void Graph::TraceRecorder::mark_profile(const Graph &graph, uint32_t options) {
-    encode_event_begin();
-    field_event_type(_encoder, EventType::ProfileMark);
+    encode_event_begin(EventType::ProfileMark);
     field_timestamp(_encoder);
     field_payload_1(_encoder, options);
     field_backtrace(_encoder);
@@ -924,8 +949,7 @@ void Graph::TraceRecorder::mark_profile(const Graph &graph, uint32_t options) {
 
 void Graph::TraceRecorder::custom_event(const Graph::Context &context, const char *event_name, const void *value,
                                         const swift::metadata &type) {
-    encode_event_begin();
-    field_event_type(_encoder, EventType::CustomEvent);
+    encode_event_begin(EventType::CustomEvent);
     field_timestamp(_encoder);
     field_backtrace(_encoder);
     field_data(_encoder, event_name, strlen(event_name));
@@ -939,8 +963,7 @@ void Graph::TraceRecorder::named_event(const Graph::Context &context, IAGNamedTr
         return;
     }
 
-    encode_event_begin();
-    field_event_type(_encoder, EventType::NamedEvent);
+    encode_event_begin(EventType::NamedEvent);
     field_named_event_id(_encoder, event_id);
     field_timestamp(_encoder);
 
@@ -11,6 +11,7 @@
 #include "ComputeCxx/IAGGraph.h"
 #include "Protobuf/Encoder.h"
 #include "Trace/Trace.h"
+#include "TraceWriter.h"
 
 IAG_ASSUME_NONNULL_BEGIN
 
@@ -29,10 +30,15 @@ class Graph::TraceRecorder : public Trace, public Encoder::Delegate {
 
     std::unique_ptr<const char, util::free_deleter> _trace_path = nullptr;
     bool _trace_path_created = false;
+    std::unique_ptr<TraceWriter> _writer = nullptr;
     
     uint32_t _num_encoded_types = 1; // skip IAGAttributeNullType
     uint32_t _num_encoded_keys = 0;
 
+    // Compact events are encoded relative to the previous event
+    uint64_t _last_timestamp = 0; // nanoseconds
+    uint32_t _last_attribute = 0;
+
     struct NamedEventInfo {
         uint32_t event_id;
         bool enabled;
@@ -51,8 +57,7 @@ class Graph::TraceRecorder : public Trace, public Encoder::Delegate {
     
     // MARK: Top-level fields
 
-    void encode_event_begin();
-    void encode_event_end();
+    void encode_format();
     void encode_subgraph(const Subgraph &subgraph);
     void encode_types();
     void encode_keys();
@@ -122,9 +127,13 @@ class Graph::TraceRecorder : public Trace, public Encoder::Delegate {
         PassedDeadline = 56
     };
 
+    void encode_event_begin(EventType event_type);
+    void encode_event_end();
+
     void field_event_type(Encoder &encoder, EventType event_type);
     void field_timestamp(Encoder &encoder);
     void field_payload_1(Encoder &encoder, uint64_t payload);
+    void field_attribute_payload_1(Encoder &encoder, uint32_t attribute);
     void field_payload_2(Encoder &encoder, uint64_t payload);
     void field_payload_3(Encoder &encoder, uint64_t payload);
     void field_backtrace(Encoder &encoder);
@@ -0,0 +1,167 @@
+#include "TraceWriter.h"
+
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+
+#include <Utilities/BlockCompression.h>
+
+namespace IAG {
+
+TraceWriter::TraceWriter(int fd, const char *path, bool compressed, bool asynchronous)
+    : _fd(fd), _path(path), _compressed(compressed) {
+    _thread_running = asynchronous && pthread_create(&_thread, nullptr, run, this) == 0;
+}
+
+TraceWriter::~TraceWriter() {
+    if (_thread_running) {
+        pthread_mutex_lock(&_mutex);
+        _stopping = true;
+        pthread_cond_broadcast(&_condition);
+        pthread_mutex_unlock(&_mutex);
+
+        pthread_join(_thread, nullptr);
+    }
+
+    close(_fd);
+    pthread_cond_destroy(&_condition);
+    pthread_mutex_destroy(&_mutex);
+}
+
+void TraceWriter::submit(Buffer &buffer) {
+    if (!_thread_running) {
+        // write on the calling thread if there is no writer thread
+        std::swap(_buffers[0], buffer);
+        _failed = _failed || !write_buffers(0, 1);
+        _buffers[0].resize(0);
+        std::swap(_buffers[0], buffer);
+        return;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    while (_count == num_buffers) {
+        pthread_cond_wait(&_condition, &_mutex);
+    }
+
+    if (_failed) {
+        buffer.resize(0);
+    } else {
+        // hand over the encoded bytes and take back an empty buffer with its capacity
+        std::swap(_buffers[(_head + _count) % num_buffers], buffer);
+        _count += 1;
+        pthread_cond_broadcast(&_condition);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void TraceWriter::sync() {
+    if (!_thread_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    while (_count > 0) {
+        pthread_cond_wait(&_condition, &_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void *TraceWriter::run(void *context) {
+    TraceWriter *writer = (TraceWriter *)context;
+
+    pthread_mutex_lock(&writer->_mutex);
+    while (true) {
+        while (writer->_count == 0 && !writer->_stopping) {
+            pthread_cond_wait(&writer->_condition, &writer->_mutex);
+        }
+        if (writer->_count == 0) {
+            break;
+        }
+
+        // Queued buffers are only touched by the writer thread until they are released below
+        uint32_t first = writer->_head;
+        uint32_t count = writer->_count;
+        bool failed = writer->_failed;
+        pthread_mutex_unlock(&writer->_mutex);
+
+        if (!failed) {
+            failed = !writer->write_buffers(first, count);
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            writer->_buffers[(first + i) % num_buffers].resize(0);
+        }
+
+        pthread_mutex_lock(&writer->_mutex);
+        writer->_failed = failed;
+        writer->_head = (first + count) % num_buffers;
+        writer->_count -= count;
+        pthread_cond_broadcast(&writer->_condition);
+    }
+    pthread_mutex_unlock(&writer->_mutex);
+
+    return nullptr;
+}
+
+bool TraceWriter::write_buffers(uint32_t first, uint32_t count) {
+    struct iovec iov[1 + num_buffers * 2];
+    int iov_count = 0;
+
+    if (_compressed && !_wrote_file_magic) {
+        _wrote_file_magic = true;
+        iov[iov_count++] = {(void *)compressed_file_magic, sizeof(compressed_file_magic)};
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t index = (first + i) % num_buffers;
+        auto &buffer = _buffers[index];
+        if (!_compressed) {
+            iov[iov_count++] = {buffer.data(), buffer.size()};
+            continue;
+        }
+
+        auto &compressed_buffer = _compressed_buffers[index];
+        compressed_buffer.resize(util::block_compression::compress_bound(buffer.size()));
+        size_t compressed_size = util::block_compression::compress(buffer.data(), buffer.size(),
+                                                                   compressed_buffer.data(), compressed_buffer.size());
+        bool stored = compressed_size == util::block_compression::failed || compressed_size >= buffer.size();
+
+        FrameHeader &frame_header = _frame_headers[index];
+        frame_header.size = uint32_t(buffer.size());
+        frame_header.stored_size = stored ? uint32_t(buffer.size()) : uint32_t(compressed_size);
+        iov[iov_count++] = {&frame_header, sizeof(FrameHeader)};
+        if (stored) {
+            iov[iov_count++] = {buffer.data(), buffer.size()};
+        } else {
+            iov[iov_count++] = {compressed_buffer.data(), compressed_size};
+        }
+    }
+
+    struct iovec *remaining = iov;
+    int remaining_count = iov_count;
+    while (remaining_count > 0) {
+        ssize_t written = writev(_fd, remaining, remaining_count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                // try again on interrupted error
+                continue;
+            }
+            unlink(_path);
+            return false;
+        }
+
+        // skip the fully written buffers and advance into a partially written one
+        while (remaining_count > 0 && (size_t)written >= remaining->iov_len) {
+            written -= remaining->iov_len;
+            remaining += 1;
+            remaining_count -= 1;
+        }
+        if (remaining_count > 0) {
+            remaining->iov_base = (char *)remaining->iov_base + written;
+            remaining->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+} // namespace IAG
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <pthread.h>
+
+#include "ComputeCxx/IAGBase.h"
+#include "Vector/Vector.h"
+
+IAG_ASSUME_NONNULL_BEGIN
+
+namespace IAG {
+
+/// Writes encoded trace buffers to a file from a dedicated thread, so the updating thread only swaps buffers.
+///
+/// Buffers are queued in a fixed ring. The writer thread writes all queued buffers with a single writev call and
+/// returns them to the ring for reuse. When the ring is full, submitting blocks until a buffer has been written.
+///
+/// When compressed, the file starts with compressed_file_magic and each buffer is written as a frame header followed
+/// by the buffer compressed with util::block_compression, or stored as is if it doesn't get smaller.
+///
+/// When not asynchronous, or if the writer thread can't be started, each buffer is written on the submitting thread.
+class TraceWriter {
+  public:
+    using Buffer = vector<char, 0, uint64_t>;
+
+    static constexpr uint32_t num_buffers = 4;
+
+    static constexpr char compressed_file_magic[8] = {'I', 'A', 'G', 'T', 'R', 'C', 'Z', '1'};
+
+    struct FrameHeader {
+        uint32_t size;
+        uint32_t stored_size; // equal to size if the buffer is stored uncompressed
+    };
+
+  private:
+    int _fd;
+    const char *_path;
+    bool _compressed;
+    bool _wrote_file_magic = false;
+
+    pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t _condition = PTHREAD_COND_INITIALIZER;
+    pthread_t _thread;
+    bool _thread_running = false;
+
+    Buffer _buffers[num_buffers];
+    Buffer _compressed_buffers[num_buffers];
+    FrameHeader _frame_headers[num_buffers];
+    uint32_t _head = 0;  // first queued buffer
+    uint32_t _count = 0; // number of queued buffers, including those being written
+    bool _stopping = false;
+    bool _failed = false;
+
+    static void *_Nullable run(void *_Nullable context);
+
+    bool write_buffers(uint32_t first, uint32_t count);
+
+  public:
+    TraceWriter(int fd, const char *path, bool compressed, bool asynchronous);
+    ~TraceWriter();
+
+    // Takes the contents of buffer, leaving it empty.
+    void submit(Buffer &buffer);
+
+    // Blocks until all submitted buffers have been written.
+    void sync();
+};
+
+} // namespace IAG
+
+IAG_ASSUME_NONNULL_END
@@ -2,6 +2,8 @@
 
 #include <ranges>
 
+#include <platform/time.h>
+
 #include "Attribute/AttributeData/Node/IndirectNode.h"
 #include "Attribute/AttributeID/OffsetAttributeID.h"
 #include "Subgraph/Subgraph.h"
@@ -249,14 +251,23 @@ Graph::UpdateStatus Graph::UpdateStack::update() {
                 return Graph::UpdateStatus::NeedsCallMainHandler;
             }
 
-            _graph->foreach_trace([&frame](Trace &trace) { trace.begin_update(frame.attribute); });
+            _graph->foreach_trace(TraceEvents::ValueUpdate, [&frame](Trace &trace) {
+                trace.begin_update(frame.attribute);
+            });
             uint64_t old_change_count = _graph->_change_count;
 
             const AttributeType &attribute_type = _graph->attribute_type(node->type_id());
             void *self = node->get_self(attribute_type);
 
+            bool profiling = _graph->is_profiling();
+            uint64_t update_start_time = profiling ? platform_absolute_time() : 0;
+
             attribute_type.update(self, IAGAttribute(AttributeID(frame.attribute)));
 
+            if (profiling) {
+                _graph->record_profile_update(frame.attribute, platform_absolute_time() - update_start_time);
+            }
+
             if (!node->is_value_initialized()) {
                 if (attribute_type.value_metadata().vw_size() > 0) {
                     precondition_failure("attribute failed to set an initial value: %u, %s", frame.attribute,
@@ -270,7 +281,9 @@ Graph::UpdateStatus Graph::UpdateStack::update() {
             }
 
             changed = _graph->_change_count != old_change_count;
-            _graph->foreach_trace([&frame, &changed](Trace &trace) { trace.end_update(frame.attribute, changed); });
+            _graph->foreach_trace(TraceEvents::ValueUpdate, [&frame, &changed](Trace &trace) {
+                trace.end_update(frame.attribute, changed);
+            });
         }
 
         // Reset flags
@@ -295,7 +308,7 @@ Graph::UpdateStatus Graph::UpdateStack::update() {
                 if (reset_edge_pending) {
                     if (frame.pending && !frame.cancelled) {
                         if (input_edge.options & IAGInputOptionsChanged) {
-                            _graph->foreach_trace([&frame, &input_index](Trace &trace) {
+                            _graph->foreach_trace(TraceEvents::EdgePending, [&frame, &input_index](Trace &trace) {
                                 trace.set_edge_pending(frame.attribute, input_index, false);
                             });
                             input_edge.options &= ~IAGInputOptionsChanged;
@@ -320,14 +333,18 @@ Graph::UpdateStatus Graph::UpdateStack::update() {
                 node->set_self_modified(false);
             }
             if (node->is_dirty()) {
-                _graph->foreach_trace([&frame](Trace &trace) { trace.set_dirty(frame.attribute, false); });
+                _graph->foreach_trace(TraceEvents::Dirty, [&frame](Trace &trace) {
+                    trace.set_dirty(frame.attribute, false);
+                });
                 node->set_dirty(false);
             }
             node->set_main_thread(node->requires_main_thread());
         }
 
         if (node->is_pending()) {
-            _graph->foreach_trace([&frame](Trace &trace) { trace.set_pending(frame.attribute, false); });
+            _graph->foreach_trace(TraceEvents::Pending, [&frame](Trace &trace) {
+                trace.set_pending(frame.attribute, false);
+            });
             node->set_pending(false);
         }
 
@@ -41,6 +41,7 @@ class Encoder {
     Encoder(Delegate *_Nullable delegate, uint64_t flush_interval);
 
     const vector<char, 0, uint64_t> &buffer() const { return _buffer; };
+    vector<char, 0, uint64_t> &buffer() { return _buffer; };
     
     void encode_field_varint(uint64_t field, uint64_t value) {
         if (value) {
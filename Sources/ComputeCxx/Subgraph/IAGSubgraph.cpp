@@ -299,6 +299,14 @@ void IAGSubgraphUpdate(IAGSubgraphRef subgraph, IAGAttributeFlags flags) {
     IAG::Subgraph::from_cf(subgraph)->update(flags);
 }
 
+uint64_t IAGSubgraphCompact(IAGSubgraphRef subgraph) {
+    if (IAG::Subgraph::from_cf(subgraph) == nullptr) {
+        return 0;
+    }
+
+    return IAG::Subgraph::from_cf(subgraph)->compact();
+}
+
 #pragma mark - Tree
 
 IAGTreeElement IAGSubgraphGetTreeRoot(IAGSubgraphRef subgraph) {
@@ -1,8 +1,7 @@
 #pragma once
 
 #include <ComputeCxx/IAGBase.h>
-#include <Utilities/HashTable.h>
-#include <Utilities/Heap.h>
+#include <Utilities/FlatTable.h>
 #include <platform/lock.h>
 
 #include "Subgraph.h"
@@ -22,7 +21,7 @@ class Subgraph::NodeCache {
         uint32_t type_id;
     };
     static_assert(sizeof(Type) == 40);
-    struct Item {
+    struct Item : Graph::NodeCacheEntry {
         uint64_t hash_and_age;
         data::ptr<Type> type;
         data::ptr<Node> node;
@@ -31,23 +30,37 @@ class Subgraph::NodeCache {
         uint8_t age() { return hash_and_age & 0xff; }
         void increment_age() { hash_and_age += 1; }
         void reset_age() { hash_and_age &= 0xffffffffffffff00; }
+        // idle items are in the graph's LRU list, until they are fetched again or collected
+        bool is_idle() { return age() != 0 && age() != 0xff; }
     };
-    static_assert(sizeof(Item) == 32);
+    static_assert(sizeof(Item) == 56);
     struct ItemKey {
         uint64_t hash_and_age; // age bits are ignored
         data::ptr<Type> type;
         data::ptr<Node> node;
         const void *_Nullable body;
     };
+    // Items are hashed by the key's hash and type, ignoring the age bits, so that a lookup by ItemKey probes the
+    // same slots as the item it finds.
+    struct ItemHash {
+        static uint64_t hash(uint64_t hash_and_age, data::ptr<Type> type) noexcept {
+            return util::mix_hash((hash_and_age >> 8) ^ type.offset());
+        }
+        uint64_t operator()(const Item *item) const noexcept { return hash(item->hash_and_age, item->type); }
+    };
+    struct NodeHash {
+        uint64_t operator()(data::ptr<Node> node) const noexcept { return util::mix_hash(node.offset()); }
+    };
 
   private:
     platform_lock _lock; // can't find how this is used..
-    util::Heap _heap;
-    util::Table<const swift::metadata *, data::ptr<Type>> _types;
-    util::Table<const ItemKey *, Item *> _items;
+    util::FlatTable<const swift::metadata *, data::ptr<Type>> _types;
+
+    // items that can be fetched, i.e. not collected
+    util::FlatTable<Item *, util::FlatNoValue, ItemHash> _items;
 
     // allocated items
-    util::Table<data::ptr<Node>, Item *> _items_by_node;
+    util::FlatTable<data::ptr<Node>, Item *, NodeHash> _items_by_node;
 
   public:
     NodeCache() noexcept;
@@ -61,9 +74,10 @@ class Subgraph::NodeCache {
     NodeCache(NodeCache &&) = delete;
     NodeCache &operator=(NodeCache &&) = delete;
 
-    util::Table<const swift::metadata *, data::ptr<Type>> &types() { return _types; };
-    util::Table<const ItemKey *, Item *> &items() { return _items; };
-    util::Table<data::ptr<Node>, Item *> &items_by_node() { return _items_by_node; };
+    util::FlatTable<const swift::metadata *, data::ptr<Type>> &types() { return _types; };
+    util::FlatTable<Item *, util::FlatNoValue, ItemHash> &items() { return _items; };
+    Item *_Nullable lookup_item(const ItemKey &item_key) const;
+    util::FlatTable<data::ptr<Node>, Item *, NodeHash> &items_by_node() { return _items_by_node; };
 };
 
 } // namespace IAG
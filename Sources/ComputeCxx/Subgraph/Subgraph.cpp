@@ -1,5 +1,6 @@
 #include "Subgraph.h"
 
+#include <algorithm>
 #include <cstring>
 #include <ranges>
 #include <stack>
@@ -43,7 +44,7 @@ Subgraph::Subgraph(SubgraphObject *object, Graph::Context &context, AttributeID
         begin_tree(attribute, nullptr, 0);
     }
 
-    context.graph().foreach_trace([this](Trace &trace) { trace.created(*this); });
+    context.graph().foreach_trace(TraceEvents::Subgraph, [this](Trace &trace) { trace.created(*this); });
 }
 
 Subgraph::~Subgraph() {
@@ -128,6 +129,7 @@ void Subgraph::notify_observers() {
 void Subgraph::invalidate_and_delete_(bool delete_zone_data) {
     if (delete_zone_data) {
         mark_deleted();
+        _graph->invalidate_indirect_resolutions(); // weak references into this subgraph have expired
     }
 
     if (is_invalidating()) {
@@ -155,7 +157,7 @@ void Subgraph::invalidate_deferred(Graph &graph) {
         graph.defer_subgraph_invalidation(*this);
         _invalidation_state = InvalidationState::Deferred;
         if (old_invalidation_state == InvalidationState::None) {
-            graph.foreach_trace([this](Trace &trace) { trace.invalidate(*this); });
+            graph.foreach_trace(TraceEvents::Subgraph, [this](Trace &trace) { trace.invalidate(*this); });
         }
     }
 }
@@ -170,7 +172,7 @@ void Subgraph::invalidate_now(Graph &graph) {
     if (_invalidation_state != InvalidationState::Completed) {
         _invalidation_state = InvalidationState::Completed;
         if (old_invalidation_state == InvalidationState::None) {
-            graph.foreach_trace([this](Trace &trace) { trace.invalidate(*this); });
+            graph.foreach_trace(TraceEvents::Subgraph, [this](Trace &trace) { trace.invalidate(*this); });
         }
         clear_object();
         invalidating_subgraphs.push(this);
@@ -179,12 +181,13 @@ void Subgraph::invalidate_now(Graph &graph) {
             Subgraph *subgraph = invalidating_subgraphs.top();
             invalidating_subgraphs.pop();
 
-            graph.foreach_trace([subgraph](Trace &trace) { trace.destroy(*subgraph); });
+            graph.foreach_trace(TraceEvents::Subgraph, [subgraph](Trace &trace) { trace.destroy(*subgraph); });
 
             notify_observers();
             graph.remove_subgraph(*subgraph);
 
             subgraph->mark_deleted();
+            graph.invalidate_indirect_resolutions();
             removed_subgraphs.push_back(subgraph);
 
             // Invalidate all children that belong to the same context
@@ -213,7 +216,9 @@ void Subgraph::invalidate_now(Graph &graph) {
                     if (child.subgraph()->_invalidation_state != InvalidationState::Completed) { // TODO: check
                         child.subgraph()->_invalidation_state = InvalidationState::Completed;
                         if (old_invalidation_state == InvalidationState::None) {
-                            graph.foreach_trace([&child](Trace &trace) { trace.invalidate(*child.subgraph()); });
+                            graph.foreach_trace(TraceEvents::Subgraph, [&child](Trace &trace) {
+                                trace.invalidate(*child.subgraph());
+                            });
                         }
                         child.subgraph()->clear_object();
                         invalidating_subgraphs.push(child.subgraph());
@@ -229,14 +234,17 @@ void Subgraph::invalidate_now(Graph &graph) {
         }
     }
 
+    // All removed subgraphs are marked invalidated at this point, so edges between their nodes are skipped and only
+    // edges into surviving subgraphs are unlinked
+    auto surviving_inputs = vector<AttributeID, 0, uint64_t>();
     for (auto removed_subgraph : removed_subgraphs) {
         for (auto page : removed_subgraph->pages()) {
             bool found_nil_attribute = false;
             for (auto attribute : attribute_view(page)) {
                 if (auto node = attribute.get_node()) {
-                    graph.remove_node(node);
+                    graph.remove_node(node, surviving_inputs);
                 } else if (auto indirect_node = attribute.get_indirect_node()) {
-                    graph.remove_indirect_node(indirect_node);
+                    graph.remove_indirect_node(indirect_node, surviving_inputs);
                 } else if (attribute.is_nil()) {
                     found_nil_attribute = true;
                     break;
@@ -247,6 +255,7 @@ void Subgraph::invalidate_now(Graph &graph) {
             }
         }
     }
+    graph.remove_removed_outputs(surviving_inputs);
 
     for (auto removed_subgraph : removed_subgraphs) {
         for (auto page : removed_subgraph->pages()) {
@@ -290,7 +299,7 @@ void Subgraph::graph_destroyed() {
     _invalidation_state = InvalidationState::GraphDestroyed;
 
     if (old_invalidation_state == InvalidationState::None) {
-        graph()->foreach_trace([this](Trace &trace) { trace.invalidate(*this); });
+        graph()->foreach_trace(TraceEvents::Subgraph, [this](Trace &trace) { trace.invalidate(*this); });
     }
 
     notify_observers();
@@ -338,7 +347,7 @@ void Subgraph::add_child(Subgraph &child, uint8_t tag) {
             precondition_failure("child already attached to new parent");
         }
     }
-    graph()->foreach_trace([this, &child](Trace &trace) { trace.add_child(*this, child); });
+    graph()->foreach_trace(TraceEvents::Subgraph, [this, &child](Trace &trace) { trace.add_child(*this, child); });
     _children.push_back(SubgraphChild(&child, tag));
 
     IAGAttributeFlags descendent_flags = child._flags | child._descendent_flags;
@@ -361,7 +370,9 @@ void Subgraph::remove_child(Subgraph &child, bool suppress_trace) {
     child._parents.erase(parent_iter, child._parents.end());
 
     if (!suppress_trace) {
-        graph()->foreach_trace([this, &child](Trace &trace) { trace.remove_child(*this, child); });
+        graph()->foreach_trace(TraceEvents::Subgraph, [this, &child](Trace &trace) {
+            trace.remove_child(*this, child);
+        });
     }
 
     auto child_iter = std::remove_if(_children.begin(), _children.end(), [&child](auto subgraph_child) -> bool {
@@ -537,14 +548,14 @@ void Subgraph::add_node(data::ptr<Node> node) {
         graph()->add_tree_data_for_subgraph(this, _tree_root, node);
     }
 
-    graph()->foreach_trace([&node](Trace &trace) { trace.added(node); });
+    graph()->foreach_trace(TraceEvents::NodeAdded, [&node](Trace &trace) { trace.added(node); });
 }
 
 void Subgraph::add_indirect(data::ptr<IndirectNode> node, bool flag) {
     insert_attribute(AttributeID(node),
                      flag); // make sure adds Indirect kind to node
 
-    graph()->foreach_trace([&node](Trace &trace) { trace.added(node); });
+    graph()->foreach_trace(TraceEvents::IndirectNode, [&node](Trace &trace) { trace.added(node); });
 }
 
 std::atomic<uint32_t> Subgraph::_last_traversal_seed = {};
@@ -629,7 +640,9 @@ void Subgraph::update(IAGAttributeFlags mask) {
         return;
     }
 
-    _graph->foreach_trace([this, &mask](Trace &trace) { trace.begin_update(*this, mask); });
+    _graph->foreach_trace(TraceEvents::SubgraphUpdate, [this, &mask](Trace &trace) {
+        trace.begin_update(*this, mask);
+    });
     _last_traversal_seed += 1;
 
     auto subgraph_objects =
@@ -716,7 +729,34 @@ void Subgraph::update(IAGAttributeFlags mask) {
     }
 
     _graph->invalidate_subgraphs();
-    _graph->foreach_trace([this](Trace &trace) { trace.end_update(*this); });
+    _graph->foreach_trace(TraceEvents::SubgraphUpdate, [this](Trace &trace) { trace.end_update(*this); });
+}
+
+#pragma mark - Compaction
+
+uint64_t Subgraph::compact() {
+    if (!is_valid() || _graph->thread_is_updating()) {
+        // update stacks hold references into edge vectors
+        return 0;
+    }
+
+    uint64_t released_bytes = 0;
+    for (auto page : pages()) {
+        for (auto attribute : attribute_view(page)) {
+            if (!attribute || attribute.is_nil()) {
+                break;
+            }
+            if (auto node = attribute.get_node()) {
+                released_bytes += node->input_edges().shrink_to_fit(this);
+                released_bytes += node->output_edges().shrink_to_fit(this);
+            } else if (auto indirect_node = attribute.get_indirect_node()) {
+                if (indirect_node->is_mutable()) {
+                    released_bytes += indirect_node->to_mutable().output_edges().shrink_to_fit(this);
+                }
+            }
+        }
+    }
+    return released_bytes;
 }
 
 #pragma mark - Cache
@@ -749,10 +789,14 @@ data::ptr<Node> Subgraph::cache_fetch(size_t hash, const swift::metadata &metada
     }
 
     NodeCache::ItemKey item_key = {hash << 8, type, nullptr, body};
-    NodeCache::Item *item = _cache->items().lookup(&item_key, nullptr);
+    NodeCache::Item *item = _cache->lookup_item(item_key);
     if (item) {
+        _graph->did_hit_node_cache();
+
         // cache hit: remove from lru (now active)
         if (item->age() > 0) {
+            _graph->node_cache_unlink(*item);
+
             // remove item from list
             if (item->next != nullptr) {
                 item->next->prev = item->prev;
@@ -769,6 +813,7 @@ data::ptr<Node> Subgraph::cache_fetch(size_t hash, const swift::metadata &metada
         }
     } else {
         // cache miss
+        _graph->did_miss_node_cache();
         if (!get_attribute_type_id) {
             return nullptr;
         }
@@ -791,7 +836,8 @@ data::ptr<Node> Subgraph::cache_fetch(size_t hash, const swift::metadata &metada
 
             // remove item
             if (item->age() != 0xff) {
-                _cache->items().remove_ptr((const NodeCache::ItemKey *)item);
+                _graph->node_cache_unlink(*item);
+                _cache->items().remove(item);
             }
 
             // reset node data
@@ -802,13 +848,14 @@ data::ptr<Node> Subgraph::cache_fetch(size_t hash, const swift::metadata &metada
             item->hash_and_age = hash << 8;
         } else {
             data::ptr<Node> node = graph()->add_attribute(*this, type->type_id, body, nullptr);
-            item = new NodeCache::Item(item_key.hash_and_age, item_key.type, node, nullptr, nullptr);
+            item = alloc(sizeof(NodeCache::Item), 7).unsafe_cast<NodeCache::Item>().get();
+            new (item) NodeCache::Item{{}, item_key.hash_and_age, item_key.type, node, nullptr, nullptr};
             node->set_cached(true);
             _cache->items_by_node().insert(node, item);
         }
 
         // reinsert in lookup map
-        _cache->items().insert((const NodeCache::ItemKey *)item, item);
+        _cache->items().insert(item, {});
     }
 
     return item->node;
@@ -837,6 +884,9 @@ void Subgraph::cache_insert(data::ptr<Node> node) {
         return; // shouldn't happen
     }
 
+    if (item->is_idle()) {
+        _graph->node_cache_unlink(*item);
+    }
     if (item->age() < 0xff) {
         item->increment_age();
     }
@@ -851,6 +901,11 @@ void Subgraph::cache_insert(data::ptr<Node> node) {
         type->lru = item;
     }
 
+    if (item->is_idle()) {
+        size_t size = node->is_value_initialized() ? attribute_type.value_metadata().vw_size() : 0;
+        _graph->node_cache_link(*item, size);
+    }
+
     if (!has_cached_nodes()) {
         if (!is_graph_invalidating_subgraphs()) {
             _graph->add_subgraphs_with_cached_nodes(*this);
@@ -866,32 +921,66 @@ void Subgraph::cache_collect() {
         return;
     }
 
-    std::pair<Subgraph *, NodeCache *> context = {this, _cache.get()};
-    _cache->types().for_each(
-        [](const swift::metadata *metadata, const data::ptr<NodeCache::Type> type, void *context) {
-            auto inner_context = reinterpret_cast<std::pair<Subgraph *, NodeCache *> *>(context);
-            Subgraph *subgraph = inner_context->first;
-            NodeCache *cache = inner_context->second;
-
-            for (NodeCache::Item *item = type->mru; item != nullptr; item = item->next) {
-                if (item->age() == 0xff) {
-                    // stop processing, all subsequent items will have age == 0xff too
-                    break;
-                }
+    NodeCache *cache = _cache.get();
+    cache->types().for_each([this, cache](const swift::metadata *metadata, const data::ptr<NodeCache::Type> type) {
+        for (NodeCache::Item *item = type->mru; item != nullptr; item = item->next) {
+            if (item->age() == 0xff) {
+                // stop processing, all subsequent items will have age == 0xff too
+                break;
+            }
 
-                item->increment_age();
+            item->increment_age();
 
-                if (item->age() == 0xff) {
-                    cache->items().remove_ptr((const NodeCache::ItemKey *)item);
-                    item->node->destroy_self(*subgraph->graph());
-                    item->node->destroy_value(*subgraph->graph());
-                    subgraph->graph()->remove_all_inputs(item->node);
-                } else {
-                    subgraph->set_has_cached_nodes(true);
-                }
+            if (item->age() == 0xff) {
+                graph()->node_cache_unlink(*item);
+                cache->items().remove(item);
+                item->node->destroy_self(*graph());
+                item->node->destroy_value(*graph());
+                graph()->remove_all_inputs(item->node);
+            } else {
+                set_has_cached_nodes(true);
             }
-        },
-        &context);
+        }
+    });
+}
+
+// Collects an idle item ahead of its age, when the graph's cached values exceed the node cache budget.
+void Subgraph::cache_evict(Graph::NodeCacheEntry &entry) {
+    auto item = static_cast<NodeCache::Item *>(&entry);
+    _graph->node_cache_unlink(*item);
+
+    // move to the lru end of the type's list, keeping ages ordered from mru to lru
+    data::ptr<NodeCache::Type> type = item->type;
+    if (item->next != nullptr) {
+        item->next->prev = item->prev;
+        if (item->prev != nullptr) {
+            item->prev->next = item->next;
+        } else {
+            type->mru = item->next;
+        }
+        item->next = nullptr;
+        item->prev = type->lru;
+        type->lru->next = item;
+        type->lru = item;
+    }
+
+    item->hash_and_age |= 0xff;
+    _cache->items().remove(item);
+    item->node->destroy_self(*_graph);
+    item->node->destroy_value(*_graph);
+    _graph->remove_all_inputs(item->node);
+}
+
+void Subgraph::cache_unlink_idle_items() {
+    if (_cache == nullptr) {
+        return;
+    }
+
+    _cache->items_by_node().for_each([this](data::ptr<Node> node, NodeCache::Item *item) {
+        if (item->is_idle()) {
+            _graph->node_cache_unlink(*item);
+        }
+    });
 }
 
 #pragma mark - Tree
@@ -912,6 +1001,8 @@ void Subgraph::begin_tree(AttributeID value, const swift::metadata *type, uint32
     if (old_root) {
         _tree_root->next_sibling = old_root->first_child;
         old_root->first_child = _tree_root;
+    } else {
+        graph()->set_tree_owner(this, AttributeID(), value);
     }
 }
 
@@ -928,6 +1019,7 @@ void Subgraph::set_tree_owner(AttributeID owner) {
     if (_tree_root->parent) {
         precondition_failure("setting owner of non-root tree");
     }
+    graph()->set_tree_owner(this, _tree_root->value, owner);
     _tree_root->value = owner;
 }
 
@@ -992,18 +1084,20 @@ Graph::TreeElementID Subgraph::tree_subgraph_child(Graph::TreeElementID tree_ele
     auto subgraph_children = vector<Subgraph *, 32, uint64_t>();
 
     // Check if any node created for _this_ tree element, is the tree owner for any child subgraph
-    for (auto subgraph : _graph->subgraphs()) {
+    for (auto iter = found; iter != nodes.end() && iter->first == tree_element; ++iter) {
+        _graph->foreach_tree_subgraph_owned_by(iter->second, [&subgraph_children](Subgraph *subgraph) {
+            if (subgraph->is_valid()) {
+                subgraph_children.push_back(subgraph);
+            }
+        });
+    }
+
+    for (auto subgraph : _graph->tree_subgraphs_with_indirect_owner()) {
         if (!subgraph->is_valid()) {
             continue;
         }
-        if (subgraph->_tree_root == nullptr) {
-            continue;
-        }
-        AttributeID attribute = subgraph->_tree_root->value;
-        if (!attribute || attribute.is_nil()) {
-            continue;
-        }
 
+        AttributeID attribute = subgraph->_tree_root->value;
         attribute = attribute.resolve(TraversalOptions::None).attribute();
         if (auto node = attribute.get_node()) {
             for (auto iter = found; iter != nodes.end(); ++iter) {
@@ -1019,6 +1113,8 @@ Graph::TreeElementID Subgraph::tree_subgraph_child(Graph::TreeElementID tree_ele
     }
 
     std::sort(subgraph_children.begin(), subgraph_children.end());
+    subgraph_children.erase(std::unique(subgraph_children.begin(), subgraph_children.end()),
+                            subgraph_children.end());
 
     auto first_tree_child = Graph::TreeElementID();
 
@@ -193,6 +193,10 @@ class Subgraph : public data::zone {
 
     void update(IAGAttributeFlags mask);
 
+    // MARK: Compaction
+
+    uint64_t compact();
+
     // MARK: Cache
 
     bool has_cached_nodes() const { return ((uint8_t)_cache_state & (uint8_t)CacheState::HasCachedNodes) != 0; };
@@ -219,6 +223,8 @@ class Subgraph : public data::zone {
     void cache_insert(data::ptr<Node> node);
 
     void cache_collect();
+    void cache_evict(Graph::NodeCacheEntry &entry);
+    void cache_unlink_idle_items();
 
     // MARK: Tree
 
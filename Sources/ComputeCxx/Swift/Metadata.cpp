@@ -257,7 +257,7 @@ const void *metadata::signature() const {
         PLATFORM_SHA1_Update(&context, prefix, sizeof(prefix));
 
         auto infos = vector<platform_image_info_t, 8, uint64_t>();
-        infos.reserve(descriptors.size());
+        infos.resize(descriptors.size());
 
         platform_image_infos_for_addresses((unsigned)descriptors.size(),
                                            static_cast<const void *[]>(descriptors.data()), infos.data());
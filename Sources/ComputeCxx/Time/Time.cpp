@@ -41,4 +41,20 @@ double absolute_time_to_seconds(uint64_t ticks) {
     return static_cast<double>(ticks) * time_scale;
 }
 
+uint64_t absolute_time_to_nanoseconds(uint64_t ticks) {
+#if TARGET_OS_MAC
+    static struct mach_timebase_info time_base = []() -> struct mach_timebase_info {
+        struct mach_timebase_info info;
+        if (mach_timebase_info(&info) || info.denom == 0) {
+            return {1, 1};
+        }
+        return info;
+    }();
+    return ticks * time_base.numer / time_base.denom;
+#else
+    // On POSIX, ticks are already nanoseconds
+    return ticks;
+#endif
+}
+
 } // namespace IAG
@@ -8,6 +8,7 @@ namespace IAG {
 
 double current_time(void);
 double absolute_time_to_seconds(uint64_t ticks);
+uint64_t absolute_time_to_nanoseconds(uint64_t ticks);
 
 }
 
@@ -5,6 +5,58 @@
 #include "Graph/Context.h"
 #include "Graph/Graph.h"
 
+IAG::TraceEvents ExternalTrace::consumed_events(const IAGTraceTypeRef trace) {
+    using IAG::TraceEvents;
+
+    TraceEvents events = TraceEvents::None;
+    auto consume_if = [&events](bool has_callback, TraceEvents callback_events) {
+        if (has_callback) {
+            events |= callback_events;
+        }
+    };
+
+    consume_if(trace->begin_subgraph_update || trace->end_subgraph_update, TraceEvents::SubgraphUpdate);
+    consume_if(trace->begin_node_update || trace->end_node_update, TraceEvents::NodeUpdate);
+    consume_if(trace->begin_value_update || trace->end_value_update, TraceEvents::ValueUpdate);
+    consume_if(trace->begin_graph_update || trace->end_graph_update, TraceEvents::ContextUpdate);
+    consume_if(trace->begin_graph_invalidation || trace->end_graph_invalidation, TraceEvents::Invalidation);
+    consume_if(trace->begin_modify_node || trace->end_modify_node, TraceEvents::Modify);
+    consume_if(trace->begin_event || trace->end_event, TraceEvents::Event);
+
+    consume_if(trace->graph_created || trace->graph_destroy, TraceEvents::Context);
+    consume_if(trace->graph_needs_update, TraceEvents::NeedsUpdate);
+    consume_if(trace->subgraph_created || trace->subgraph_destroy || trace->subgraph_add_child ||
+                   trace->subgraph_remove_child,
+               TraceEvents::Subgraph);
+
+    consume_if(trace->node_added, TraceEvents::NodeAdded);
+    consume_if(trace->node_add_edge || trace->node_remove_edge, TraceEvents::Edge);
+    consume_if(trace->node_set_edge_pending, TraceEvents::EdgePending);
+    consume_if(trace->node_set_dirty, TraceEvents::Dirty);
+    consume_if(trace->node_set_pending, TraceEvents::Pending);
+    consume_if(trace->node_set_value || trace->node_mark_value, TraceEvents::Value);
+    consume_if(trace->indirect_node_added || trace->indirect_node_set_source || trace->indirect_node_set_dependency,
+               TraceEvents::IndirectNode);
+
+    consume_if(trace->profile_mark, TraceEvents::Profile);
+
+    // Callbacks added in later versions are not present in earlier trace types
+    if (trace->version >= IAGTraceTypeVersionCustom) {
+        consume_if(trace->custom_event, TraceEvents::Custom);
+    }
+    if (trace->version >= IAGTraceTypeVersionNamed) {
+        consume_if(trace->named_event, TraceEvents::Named);
+    }
+    if (trace->version >= IAGTraceTypeVersionDeadline) {
+        consume_if(trace->set_deadline || trace->passed_deadline, TraceEvents::Deadline);
+    }
+    if (trace->version >= IAGTraceTypeVersionCompareFailed) {
+        consume_if(trace->compare_failed, TraceEvents::CompareFailed);
+    }
+
+    return events;
+}
+
 void ExternalTrace::graph_destroyed() { delete this; };
 
 void ExternalTrace::trace_removed() { delete this; };
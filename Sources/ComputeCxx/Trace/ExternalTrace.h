@@ -18,10 +18,16 @@ class ExternalTrace : public IAG::Trace {
     const IAGTraceTypeRef _trace;
     void *_Nullable _context;
 
+    static IAG::TraceEvents consumed_events(const IAGTraceTypeRef trace);
+
   public:
-    ExternalTrace(IAGTraceTypeRef trace, void *context) : _trace(trace), _context(context) {};
+    ExternalTrace(IAGTraceTypeRef trace, void *context) : _trace(trace), _context(context) {
+        _events = consumed_events(trace);
+    };
     ExternalTrace(IAGUniqueID id, const IAGTraceTypeRef trace, void *context)
-        : IAG::Trace(id), _trace(trace), _context(context) {};
+        : IAG::Trace(id), _trace(trace), _context(context) {
+        _events = consumed_events(trace);
+    };
 
     void graph_destroyed() override;
     void trace_removed() override;
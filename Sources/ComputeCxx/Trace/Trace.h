@@ -11,6 +11,7 @@
 #include "ComputeCxx/IAGGraph.h"
 #include "ComputeCxx/IAGUniqueID.h"
 #include "Graph/Graph.h"
+#include "Trace/TraceEvents.h"
 
 IAG_ASSUME_NONNULL_BEGIN
 
@@ -22,10 +23,15 @@ class Subgraph;
 class Trace {
   protected:
     IAGUniqueID _id;
+    TraceEvents _events = TraceEvents::All;
 
   public:
     IAGUniqueID id() { return _id; }
 
+    /// The events this trace consumes. The graph only dispatches events of these kinds to it, so this must not
+    /// change once the trace has been added to a graph.
+    TraceEvents events() const { return _events; }
+
     Trace() : _id(IAGMakeUniqueID()) {};
     Trace(uint64_t id) : _id(id) {};
 
@@ -104,6 +110,19 @@ class Trace {
                                 size_t range_size, const swift::metadata *_Nullable type) {};
 };
 
+template <typename T>
+    requires std::invocable<T, Trace &>
+void Graph::foreach_trace(TraceEvents events, T body) {
+    if (!has_trace_events(events)) {
+        return;
+    }
+    for (auto trace : std::ranges::reverse_view(_traces)) {
+        if ((trace->events() & events) != TraceEvents::None) {
+            body(*trace);
+        }
+    }
+};
+
 } // namespace IAG
 
 IAG_ASSUME_NONNULL_END
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ComputeCxx/IAGBase.h"
+
+IAG_ASSUME_NONNULL_BEGIN
+
+namespace IAG {
+
+/// The kinds of event a trace consumes, each covering one or more of the methods of `Trace`.
+enum class TraceEvents : uint32_t {
+    None = 0,
+
+    SubgraphUpdate = 1 << 0,
+    NodeUpdate = 1 << 1,
+    ValueUpdate = 1 << 2,
+    ContextUpdate = 1 << 3,
+    Invalidation = 1 << 4,
+    Modify = 1 << 5,
+    Event = 1 << 6,
+
+    Context = 1 << 7,
+    NeedsUpdate = 1 << 8,
+    Subgraph = 1 << 9,
+
+    NodeAdded = 1 << 10,
+    Edge = 1 << 11,
+    EdgePending = 1 << 12,
+    Dirty = 1 << 13,
+    Pending = 1 << 14,
+    Value = 1 << 15,
+    IndirectNode = 1 << 16,
+
+    Deadline = 1 << 17,
+    Profile = 1 << 18,
+    Custom = 1 << 19,
+    Named = 1 << 20,
+    CompareFailed = 1 << 21,
+    Log = 1 << 22,
+
+    All = (1 << 23) - 1,
+};
+inline TraceEvents operator|(TraceEvents a, TraceEvents b) {
+    return static_cast<TraceEvents>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+inline TraceEvents operator&(TraceEvents a, TraceEvents b) {
+    return static_cast<TraceEvents>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
+}
+inline TraceEvents operator~(TraceEvents a) { return static_cast<TraceEvents>(~static_cast<uint32_t>(a)); }
+inline TraceEvents &operator|=(TraceEvents &lhs, TraceEvents rhs) {
+    lhs = lhs | rhs;
+    return lhs;
+}
+
+} // namespace IAG
+
+IAG_ASSUME_NONNULL_END
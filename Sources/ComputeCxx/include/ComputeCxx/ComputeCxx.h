@@ -11,8 +11,10 @@
 #include <ComputeCxx/IAGDescription.h>
 #include <ComputeCxx/IAGGraph.h>
 #include <ComputeCxx/IAGGraphCounterQueryType.h>
+#include <ComputeCxx/IAGGraphSnapshot.h>
 #include <ComputeCxx/IAGGraphTracing.h>
 #include <ComputeCxx/IAGInputOptions.h>
+#include <ComputeCxx/IAGProfileEntry.h>
 #include <ComputeCxx/IAGSearchOptions.h>
 #include <ComputeCxx/IAGSubgraph.h>
 #include <ComputeCxx/IAGTargetConditionals.h>
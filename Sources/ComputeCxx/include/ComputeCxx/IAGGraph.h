@@ -20,6 +20,7 @@
 #include <ComputeCxx/IAGComparison.h>
 #include <ComputeCxx/IAGGraphCounterQueryType.h>
 #include <ComputeCxx/IAGInputOptions.h>
+#include <ComputeCxx/IAGProfileEntry.h>
 #include <ComputeCxx/IAGSearchOptions.h>
 #include <ComputeCxx/IAGType.h>
 #include <ComputeCxx/IAGValue.h>
@@ -80,6 +81,12 @@ IAG_REFINED_FOR_SWIFT
 uint64_t IAGGraphGetCounter(IAGGraphRef graph, IAGGraphCounterQueryType query)
     IAG_SWIFT_NAME(IAGGraphRef.counter(self:for:));
 
+// MARK: Data
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+const void *_Nullable IAGGraphGetVMRegionBaseAddress(void) IAG_SWIFT_NAME(getter:IAGGraphRef.vmRegionBaseAddress());
+
 // MARK: Main handler
 
 IAG_EXPORT
@@ -220,6 +227,12 @@ IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 bool IAGGraphSetValue(IAGAttribute attribute, const void *value, IAGTypeID type);
 
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+uint64_t IAGGraphSetValues(const IAGAttribute *IAG_COUNTED_BY(count) attributes,
+                           const void *_Nonnull const *_Nonnull values, const IAGTypeID _Nonnull *_Nonnull types,
+                           size_t count);
+
 IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 bool IAGGraphHasValue(IAGAttribute attribute) IAG_SWIFT_NAME(getter:IAGAttribute.hasValue(self:));
@@ -250,6 +263,10 @@ IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 void IAGGraphInvalidateValue(IAGAttribute attribute) IAG_SWIFT_NAME(IAGAttribute.invalidateValue(self:));
 
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+void IAGGraphInvalidateValues(const IAGAttribute *IAG_COUNTED_BY(count) attributes, size_t count);
+
 IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 void IAGGraphInvalidateAllValues(IAGGraphRef graph) IAG_SWIFT_NAME(IAGGraphRef.invalidateAllValues(self:));
@@ -277,6 +294,15 @@ void *_Nullable IAGGraphReadCachedAttributeIfExists(size_t hash, IAGTypeID type,
                                                    IAGCachedValueOptions options, IAGAttribute owner,
                                                    bool *_Nullable changed_out);
 
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+uint64_t IAGGraphGetNodeCacheBudget(IAGGraphRef graph) IAG_SWIFT_NAME(getter:IAGGraphRef.nodeCacheBudget(self:));
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+void IAGGraphSetNodeCacheBudget(IAGGraphRef graph, uint64_t budget)
+    IAG_SWIFT_NAME(setter:IAGGraphRef.nodeCacheBudget(self:_:));
+
 // MARK: Update
 
 typedef IAG_ENUM(uint32_t, IAGGraphUpdateStatus) {
@@ -358,6 +384,25 @@ IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 void IAGGraphSetOutputValue(const void *value, IAGTypeID type);
 
+// MARK: Profile
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+void IAGGraphStartProfiling(IAGGraphRef _Nullable graph);
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+void IAGGraphStopProfiling(IAGGraphRef _Nullable graph);
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+void IAGGraphResetProfile(IAGGraphRef _Nullable graph);
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+size_t IAGGraphCopyProfileData(IAGGraphRef graph, IAGProfileEntry *_Nullable IAG_COUNTED_BY(capacity) entries,
+                               size_t capacity);
+
 // MARK: Description
 
 #if TARGET_OS_MAC
@@ -365,6 +410,25 @@ IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 CFTypeRef _Nullable IAGGraphDescription(IAGGraphRef _Nullable graph, CFDictionaryRef options)
     IAG_SWIFT_NAME(IAGGraphRef.description(_:options:));
+#endif
+
+typedef IAG_OPTIONS(uint32_t, IAGGraphExportOptions) {
+    IAGGraphExportOptionsNone = 0,
+    IAGGraphExportOptionsIncludeValues = 1 << 0,
+    IAGGraphExportOptionsAllGraphs = 1 << 1,
+};
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+bool IAGGraphExportJSON(IAGGraphRef _Nullable graph, int fd, IAGGraphExportOptions options);
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+bool IAGGraphExportDot(IAGGraphRef graph, int fd, IAGGraphExportOptions options);
+
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+bool IAGGraphWriteSnapshot(IAGGraphRef graph, int fd);
 
 IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
@@ -374,7 +438,6 @@ IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 void IAGGraphArchiveJSON2(const char *filename, bool exclude_values)
     IAG_SWIFT_NAME(IAGGraphRef.archiveJSON(name:excludeValues:));
-#endif
 
 IAG_EXTERN_C_END
 
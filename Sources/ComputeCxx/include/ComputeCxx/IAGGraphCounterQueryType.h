@@ -17,4 +17,16 @@ typedef IAG_ENUM(uint32_t, IAGGraphCounterQueryType) {
     IAGGraphCounterQueryTypeCreatedNodes,
     IAGGraphCounterQueryTypeSubgraphs,
     IAGGraphCounterQueryTypeCreatedSubgraphs,
+    IAGGraphCounterQueryTypeNodeCacheHits,
+    IAGGraphCounterQueryTypeNodeCacheMisses,
+    IAGGraphCounterQueryTypeNodeCacheEvictions,
+    IAGGraphCounterQueryTypeNodeCacheBytes,
+    IAGGraphCounterQueryTypeDataBytes,
+    IAGGraphCounterQueryTypeDataCachedBytes,
+    IAGGraphCounterQueryTypeDataMappedBytes,
+    IAGGraphCounterQueryTypeRecycledAllocations,
+    IAGGraphCounterQueryTypeRecycledBytes,
+    IAGGraphCounterQueryTypeTraceEvents,
+    IAGGraphCounterQueryTypeIndirectResolutionHits,
+    IAGGraphCounterQueryTypeIndirectResolutionMisses,
 } IAG_SWIFT_NAME(IAGGraphRef.CounterQueryType);
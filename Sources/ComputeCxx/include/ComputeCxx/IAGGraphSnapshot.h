@@ -0,0 +1,108 @@
+#pragma once
+
+#include <ComputeCxx/IAGBase.h>
+
+IAG_ASSUME_NONNULL_BEGIN
+
+IAG_EXTERN_C_BEGIN
+
+#define IAG_GRAPH_SNAPSHOT_MAGIC "IAGSNAP"
+#define IAG_GRAPH_SNAPSHOT_VERSION 1
+#define IAG_GRAPH_SNAPSHOT_NO_INDEX UINT32_MAX
+
+typedef IAG_ENUM(uint32_t, IAGGraphSnapshotSectionKind) {
+    IAGGraphSnapshotSectionKindStrings = 0,
+    IAGGraphSnapshotSectionKindTypes = 1,
+    IAGGraphSnapshotSectionKindSubgraphs = 2,
+    IAGGraphSnapshotSectionKindNodes = 3,
+    IAGGraphSnapshotSectionKindInputEdges = 4,
+    IAGGraphSnapshotSectionKindOutputEdges = 5,
+    IAGGraphSnapshotSectionKindKeys = 6,
+    IAGGraphSnapshotSectionKindTrees = 7,
+    IAGGraphSnapshotSectionKindTreeValues = 8,
+    IAGGraphSnapshotSectionKindCount = 9,
+};
+
+typedef struct IAGGraphSnapshotSection {
+    uint64_t offset;
+    uint32_t count;
+    uint32_t record_size;
+} IAGGraphSnapshotSection;
+
+typedef struct IAGGraphSnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t graph_id;
+    uint64_t file_size;
+    IAGGraphSnapshotSection sections[IAGGraphSnapshotSectionKindCount];
+} IAGGraphSnapshotHeader;
+
+typedef struct IAGGraphSnapshotType {
+    uint32_t name;
+    uint32_t value_name;
+    uint32_t self_size;
+    uint32_t value_size;
+    uint32_t flags;
+} IAGGraphSnapshotType;
+
+typedef struct IAGGraphSnapshotSubgraph {
+    uint64_t context_id;
+    uint32_t id;
+    uint32_t invalid;
+    uint32_t first_node;
+    uint32_t node_count;
+    uint32_t tree_root;
+    uint32_t reserved;
+} IAGGraphSnapshotSubgraph;
+
+typedef struct IAGGraphSnapshotNode {
+    uint32_t attribute;
+    uint32_t type_id;
+    uint32_t subgraph;
+    uint32_t state;
+    uint32_t subgraph_flags;
+    uint32_t first_input_edge;
+    uint32_t input_edge_count;
+    uint32_t first_output_edge;
+    uint32_t output_edge_count;
+} IAGGraphSnapshotNode;
+
+typedef struct IAGGraphSnapshotInputEdge {
+    uint32_t attribute;
+    uint32_t node;
+    uint32_t offset;
+    uint32_t options;
+} IAGGraphSnapshotInputEdge;
+
+typedef struct IAGGraphSnapshotOutputEdge {
+    uint32_t attribute;
+    uint32_t node;
+} IAGGraphSnapshotOutputEdge;
+
+typedef struct IAGGraphSnapshotKey {
+    uint32_t name;
+} IAGGraphSnapshotKey;
+
+typedef struct IAGGraphSnapshotTree {
+    uint32_t value;
+    uint32_t node;
+    uint32_t type_name;
+    uint32_t flags;
+    uint32_t parent;
+    uint32_t first_child;
+    uint32_t next_sibling;
+    uint32_t first_value;
+} IAGGraphSnapshotTree;
+
+typedef struct IAGGraphSnapshotTreeValue {
+    uint32_t key_id;
+    uint32_t value;
+    uint32_t node;
+    uint32_t offset;
+    uint32_t next;
+} IAGGraphSnapshotTreeValue;
+
+IAG_EXTERN_C_END
+
+IAG_ASSUME_NONNULL_END
@@ -11,6 +11,8 @@ typedef IAG_OPTIONS(uint32_t, IAGGraphTraceFlags) {
     IAGGraphTraceFlagsPrepare = 1 << 3,
     IAGGraphTraceFlagsCustom = 1 << 4,
     IAGGraphTraceFlagsAll = 1 << 5,
+    IAGGraphTraceFlagsCompact = 1 << 6,
+    IAGGraphTraceFlagsCompressed = 1 << 7,
 } IAG_SWIFT_NAME(IAGGraphRef.TraceFlags);
 
 typedef struct IAGTraceType *IAGTraceTypeRef;
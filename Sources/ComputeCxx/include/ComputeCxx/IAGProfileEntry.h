@@ -0,0 +1,22 @@
+#pragma once
+
+#include <ComputeCxx/IAGBase.h>
+
+IAG_ASSUME_NONNULL_BEGIN
+
+IAG_EXTERN_C_BEGIN
+
+#define IAG_PROFILE_HISTOGRAM_BUCKET_COUNT 32
+
+typedef struct IAGProfileEntry {
+    uint32_t type_id;
+    uint32_t subgraph_id;
+    uint64_t update_count;
+    uint64_t total_duration;
+    uint64_t max_duration;
+    uint64_t histogram[IAG_PROFILE_HISTOGRAM_BUCKET_COUNT];
+} IAGProfileEntry;
+
+IAG_EXTERN_C_END
+
+IAG_ASSUME_NONNULL_END
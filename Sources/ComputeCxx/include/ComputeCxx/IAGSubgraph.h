@@ -149,6 +149,10 @@ IAG_EXPORT
 IAG_REFINED_FOR_SWIFT
 void IAGSubgraphUpdate(IAGSubgraphRef subgraph, IAGAttributeFlags flags) IAG_SWIFT_NAME(IAGSubgraphRef.update(self:flags:));
 
+IAG_EXPORT
+IAG_REFINED_FOR_SWIFT
+uint64_t IAGSubgraphCompact(IAGSubgraphRef subgraph) IAG_SWIFT_NAME(IAGSubgraphRef.compact(self:));
+
 // MARK: Tree
 
 IAG_EXPORT
@@ -4,10 +4,70 @@
 #include <dlfcn.h>
 
 #include "MachOFile.h"
+#elif __linux__
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <string.h>
 #endif
 
 #include <strings.h>
 
+#if __linux__
+
+namespace {
+
+struct build_id_search {
+    const void *base;
+    unsigned char *identifier;
+};
+
+// Copies the GNU build ID of the image loaded at search->base, truncated to the identifier length.
+int copy_build_id(struct dl_phdr_info *info, size_t size, void *context) {
+    auto search = static_cast<build_id_search *>(context);
+
+    bool is_image = false;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+        if (phdr.p_type == PT_LOAD && phdr.p_offset == 0) {
+            is_image = (const void *)(info->dlpi_addr + phdr.p_vaddr) == search->base;
+            break;
+        }
+    }
+    if (!is_image) {
+        return 0;
+    }
+
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_NOTE) {
+            continue;
+        }
+
+        auto notes = reinterpret_cast<const unsigned char *>(info->dlpi_addr + phdr.p_vaddr);
+        size_t offset = 0;
+        while (offset + sizeof(ElfW(Nhdr)) <= phdr.p_memsz) {
+            auto note = reinterpret_cast<const ElfW(Nhdr) *>(notes + offset);
+            size_t name_offset = offset + sizeof(ElfW(Nhdr));
+            size_t desc_offset = name_offset + ((note->n_namesz + 3) & ~3);
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 &&
+                memcmp(notes + name_offset, "GNU", 4) == 0) {
+                size_t length = note->n_descsz < PLATFORM_IMAGE_INFO_IDENTIFIER_LENGTH
+                                    ? note->n_descsz
+                                    : PLATFORM_IMAGE_INFO_IDENTIFIER_LENGTH;
+                memcpy(search->identifier, notes + desc_offset, length);
+                return 1;
+            }
+            offset = desc_offset + ((note->n_descsz + 3) & ~3);
+        }
+    }
+    return 1;
+}
+
+} // namespace
+
+#endif
+
 void platform_image_infos_for_addresses(unsigned count, const void *_Nonnull addresses[_Nonnull],
                                         platform_image_info_t infos[_Nonnull]) {
     for (unsigned i = 0; i < count; i++) {
@@ -27,6 +87,14 @@ void platform_image_infos_for_addresses(unsigned count, const void *_Nonnull add
                 bzero(infos[i].identifier, sizeof(uuid_t));
             }
         }
+#elif __linux__
+        Dl_info dl_info;
+        if (dladdr(addr, &dl_info)) {
+            infos[i].offset = (uintptr_t)addr - (uintptr_t)dl_info.dli_fbase;
+
+            build_id_search search = {dl_info.dli_fbase, infos[i].identifier};
+            dl_iterate_phdr(copy_build_id, &search);
+        }
 #else
         // TODO
 #endif
@@ -0,0 +1,184 @@
+#include "Utilities/BlockCompression.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace util {
+namespace block_compression {
+
+namespace {
+
+constexpr size_t min_match_length = 4;
+constexpr size_t max_offset = 0xffff;
+constexpr uint32_t hash_bits = 12;
+
+uint32_t read_uint32(const uint8_t *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+uint32_t hash_sequence(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - hash_bits); }
+
+bool write_extra_length(uint8_t *&output, const uint8_t *output_end, size_t length) {
+    while (length >= 255) {
+        if (output == output_end) {
+            return false;
+        }
+        *output++ = 255;
+        length -= 255;
+    }
+    if (output == output_end) {
+        return false;
+    }
+    *output++ = uint8_t(length);
+    return true;
+}
+
+bool read_extra_length(const uint8_t *&input, const uint8_t *input_end, size_t &length) {
+    uint8_t byte;
+    do {
+        if (input == input_end) {
+            return false;
+        }
+        byte = *input++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Writes a record, or the last record of the block if match_length is zero.
+bool write_record(uint8_t *&output, const uint8_t *output_end, const uint8_t *literals, size_t literal_length,
+                  size_t offset, size_t match_length) {
+    if (output == output_end) {
+        return false;
+    }
+
+    size_t match_code = match_length ? match_length - min_match_length : 0;
+    uint8_t *token = output++;
+    *token = uint8_t(std::min<size_t>(literal_length, 15) << 4 | std::min<size_t>(match_code, 15));
+
+    if (literal_length >= 15 && !write_extra_length(output, output_end, literal_length - 15)) {
+        return false;
+    }
+    if (size_t(output_end - output) < literal_length) {
+        return false;
+    }
+    if (literal_length > 0) {
+        memcpy(output, literals, literal_length);
+        output += literal_length;
+    }
+
+    if (match_length) {
+        if (output_end - output < 2) {
+            return false;
+        }
+        *output++ = uint8_t(offset);
+        *output++ = uint8_t(offset >> 8);
+        if (match_code >= 15 && !write_extra_length(output, output_end, match_code - 15)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+size_t compress(const void *source, size_t source_size, void *destination, size_t destination_capacity) {
+    const uint8_t *input_start = static_cast<const uint8_t *>(source);
+    const uint8_t *input_end = input_start + source_size;
+    uint8_t *output_start = static_cast<uint8_t *>(destination);
+    uint8_t *output = output_start;
+    const uint8_t *output_end = output_start + destination_capacity;
+
+    // Positions of the last sequence of four bytes with each hash
+    uint32_t positions[1 << hash_bits] = {};
+
+    const uint8_t *literals = input_start;
+    const uint8_t *input = input_start;
+    while (input_end - input >= (ptrdiff_t)min_match_length) {
+        uint32_t sequence = read_uint32(input);
+        uint32_t &position = positions[hash_sequence(sequence)];
+        const uint8_t *candidate = input_start + position;
+        position = uint32_t(input - input_start);
+
+        if (candidate >= input || size_t(input - candidate) > max_offset || read_uint32(candidate) != sequence) {
+            input += 1;
+            continue;
+        }
+
+        size_t match_length = min_match_length;
+        while (input + match_length < input_end && candidate[match_length] == input[match_length]) {
+            match_length += 1;
+        }
+
+        if (!write_record(output, output_end, literals, input - literals, input - candidate, match_length)) {
+            return failed;
+        }
+        input += match_length;
+        literals = input;
+    }
+
+    if (!write_record(output, output_end, literals, input_end - literals, 0, 0)) {
+        return failed;
+    }
+    return output - output_start;
+}
+
+size_t decompress(const void *source, size_t source_size, void *destination, size_t destination_capacity) {
+    const uint8_t *input = static_cast<const uint8_t *>(source);
+    const uint8_t *input_end = input + source_size;
+    uint8_t *output_start = static_cast<uint8_t *>(destination);
+    uint8_t *output = output_start;
+    const uint8_t *output_end = output_start + destination_capacity;
+
+    while (input < input_end) {
+        uint8_t token = *input++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_extra_length(input, input_end, literal_length)) {
+            return failed;
+        }
+        if (size_t(input_end - input) < literal_length || size_t(output_end - output) < literal_length) {
+            return failed;
+        }
+        if (literal_length > 0) {
+            memcpy(output, input, literal_length);
+            input += literal_length;
+            output += literal_length;
+        }
+
+        if (input == input_end) {
+            break;
+        }
+
+        if (input_end - input < 2) {
+            return failed;
+        }
+        size_t offset = size_t(input[0]) | size_t(input[1]) << 8;
+        input += 2;
+        if (offset == 0 || offset > size_t(output - output_start)) {
+            return failed;
+        }
+
+        size_t match_length = token & 0xf;
+        if (match_length == 15 && !read_extra_length(input, input_end, match_length)) {
+            return failed;
+        }
+        match_length += min_match_length;
+        if (size_t(output_end - output) < match_length) {
+            return failed;
+        }
+
+        // copied forwards one byte at a time, since the match may overlap the output it is repeating
+        const uint8_t *match = output - offset;
+        for (size_t i = 0; i < match_length; ++i) {
+            *output++ = *match++;
+        }
+    }
+
+    return output - output_start;
+}
+
+} // namespace block_compression
+} // namespace util
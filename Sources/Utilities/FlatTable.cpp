@@ -0,0 +1,25 @@
+#include "Utilities/FlatTable.h"
+
+namespace util {
+
+UntypedFlatTable *UntypedFlatTable::create() { return new UntypedFlatTable(); }
+
+void UntypedFlatTable::destroy(UntypedFlatTable *value) { delete value; }
+
+#pragma mark - Lookup
+
+UntypedFlatTable::value_type UntypedFlatTable::lookup(key_type key, nullable_key_type *found_key_out) const noexcept {
+    return _table.lookup(key, found_key_out);
+}
+
+void UntypedFlatTable::for_each(entry_callback body, void *context) const {
+    _table.for_each([body, context](const void *key, const void *value) { body(key, value, context); });
+}
+
+#pragma mark - Modifying entries
+
+bool UntypedFlatTable::insert(key_type key, value_type value) { return _table.insert(key, value); }
+
+bool UntypedFlatTable::remove(key_type key) { return _table.remove(key); }
+
+} // namespace util
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Utilities/Base.h>
+
+UTIL_ASSUME_NONNULL_BEGIN
+
+namespace util {
+
+/// A byte-oriented LZ77 block format for buffers that are compressed independently, such as flushed trace buffers.
+///
+/// A block is a sequence of records, each a token byte followed by literals and a match. The high four bits of the
+/// token are the literal length and the low four bits are the match length minus four; a value of 15 is continued by
+/// extra length bytes, each added to it and continued while it is 255. The literals are followed by a two byte little
+/// endian offset back into the output, from which the match is copied. The last record has no offset or match, and
+/// ends the block. Blocks must be smaller than 4 GiB.
+namespace block_compression {
+
+constexpr size_t failed = SIZE_MAX;
+
+/// Returns the largest size a block of source_size bytes can compress to.
+inline size_t compress_bound(size_t source_size) { return source_size + source_size / 255 + 16; }
+
+/// Returns the compressed size, or failed if it would not fit in destination_capacity bytes.
+size_t compress(const void *source, size_t source_size, void *destination, size_t destination_capacity);
+
+/// Returns the decompressed size, or failed if the block is malformed or would not fit in destination_capacity
+/// bytes.
+size_t decompress(const void *source, size_t source_size, void *destination, size_t destination_capacity);
+
+} // namespace block_compression
+
+} // namespace util
+
+UTIL_ASSUME_NONNULL_END
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <Utilities/Base.h>
+#include <Utilities/SwiftBridging.h>
+
+UTIL_ASSUME_NONNULL_BEGIN
+
+namespace util {
+
+// Finalizer from MurmurHash3, spreads the entropy of pointers and small integers across all bits.
+inline uint64_t mix_hash(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccd;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53;
+    value ^= value >> 33;
+    return value;
+}
+
+template <typename Key> struct FlatHash {
+    uint64_t operator()(const Key key) const noexcept {
+        if constexpr (std::is_pointer_v<Key>) {
+            return mix_hash((uint64_t)(uintptr_t)key);
+        } else {
+            return mix_hash((uint64_t)key);
+        }
+    }
+};
+
+template <typename Key> struct FlatEqual {
+    bool operator()(const Key a, const Key b) const noexcept { return a == b; }
+};
+
+// Value type for tables that are only used as a set of keys, taking no space in the slots.
+struct FlatNoValue {};
+
+namespace flat_table {
+
+// Each slot has a control byte: full slots store the low 7 bits of the hash, empty and deleted slots have the high
+// bit set so a whole group can be tested with a single comparison.
+using ctrl_t = int8_t;
+constexpr ctrl_t ctrl_empty = -128;  // 0b10000000
+constexpr ctrl_t ctrl_deleted = -2;  // 0b11111110
+
+template <typename T, uint32_t Shift> class BitMask {
+  private:
+    T _mask;
+
+  public:
+    explicit BitMask(T mask) : _mask(mask) {};
+
+    explicit operator bool() const { return _mask != 0; };
+    uint32_t lowest() const { return uint32_t(__builtin_ctzll(_mask)) >> Shift; };
+    void clear_lowest() { _mask &= _mask - 1; };
+};
+
+#if defined(__SSE2__)
+
+class Group {
+  private:
+    __m128i _ctrl;
+
+  public:
+    static constexpr size_t width = 16;
+
+    explicit Group(const ctrl_t *ctrl) : _ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl))) {};
+
+    BitMask<uint32_t, 0> match(ctrl_t h2) const {
+        return BitMask<uint32_t, 0>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl)));
+    };
+    BitMask<uint32_t, 0> match_empty() const {
+        return BitMask<uint32_t, 0>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), _ctrl)));
+    };
+    BitMask<uint32_t, 0> match_empty_or_deleted() const {
+        return BitMask<uint32_t, 0>(_mm_movemask_epi8(_ctrl));
+    };
+};
+
+#else
+
+// Portable group that tests eight control bytes at once within a 64-bit word. Assumes a little-endian target.
+class Group {
+  private:
+    static constexpr uint64_t lsbs = 0x0101010101010101;
+    static constexpr uint64_t msbs = 0x8080808080808080;
+
+    uint64_t _ctrl;
+
+  public:
+    static constexpr size_t width = 8;
+
+    explicit Group(const ctrl_t *ctrl) { memcpy(&_ctrl, ctrl, sizeof(_ctrl)); };
+
+    // May report false positives after a true match, which are rejected when the keys are compared.
+    BitMask<uint64_t, 3> match(ctrl_t h2) const {
+        uint64_t x = _ctrl ^ (lsbs * uint8_t(h2));
+        return BitMask<uint64_t, 3>((x - lsbs) & ~x & msbs);
+    };
+    BitMask<uint64_t, 3> match_empty() const { return BitMask<uint64_t, 3>(_ctrl & ~(_ctrl << 1) & msbs); };
+    BitMask<uint64_t, 3> match_empty_or_deleted() const { return BitMask<uint64_t, 3>(_ctrl & msbs); };
+};
+
+#endif
+
+} // namespace flat_table
+
+/// An open-addressing hash table storing keys and values inline, probed a group of slots at a time.
+///
+/// Unlike Table, the hasher and comparator are template parameters so they can be inlined into lookups, and entries
+/// aren't separately allocated nodes. Keys and values must be trivially copyable.
+template <typename Key, typename Value, typename Hash = FlatHash<Key>, typename Equal = FlatEqual<Key>>
+class FlatTable {
+  public:
+    using key_type = Key;
+    using value_type = Value;
+    using size_type = uint64_t;
+
+  private:
+    using Group = flat_table::Group;
+    using ctrl_t = flat_table::ctrl_t;
+
+    struct Slot {
+        Key key;
+        [[no_unique_address]] Value value;
+    };
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>);
+    static_assert(alignof(Slot) <= Group::width);
+
+    static constexpr size_type not_found = ~size_type(0);
+
+    ctrl_t *_Nullable _ctrl = nullptr;
+    Slot *_Nullable _slots = nullptr;
+    size_type _capacity = 0;
+    size_type _count = 0;
+    size_type _growth_left = 0;
+    [[no_unique_address]] Hash _hash;
+    [[no_unique_address]] Equal _equal;
+
+    static ctrl_t h2(uint64_t hash) { return ctrl_t(hash & 0x7f); };
+
+    // Visits groups in triangular steps from the group selected by the hash, which reaches every group once when
+    // the number of groups is a power of two.
+    class ProbeSequence {
+      private:
+        size_type _group_mask;
+        size_type _group_index;
+        size_type _step = 0;
+
+      public:
+        ProbeSequence(uint64_t hash, size_type capacity)
+            : _group_mask(capacity / Group::width - 1), _group_index((hash >> 7) & _group_mask) {};
+
+        size_type group_start() const { return _group_index * Group::width; };
+        void next() {
+            _step += 1;
+            _group_index = (_group_index + _step) & _group_mask;
+        };
+    };
+
+    template <typename Predicate> size_type find_index_if(uint64_t hash, Predicate predicate) const {
+        if (_count == 0) {
+            return not_found;
+        }
+        ctrl_t tag = h2(hash);
+        for (auto probe = ProbeSequence(hash, _capacity);; probe.next()) {
+            Group group = Group(_ctrl + probe.group_start());
+            for (auto match = group.match(tag); match; match.clear_lowest()) {
+                size_type index = probe.group_start() + match.lowest();
+                if (predicate(_slots[index].key)) {
+                    return index;
+                }
+            }
+            if (group.match_empty()) {
+                return not_found;
+            }
+        }
+    };
+
+    size_type find_index(const key_type key, uint64_t hash) const {
+        return find_index_if(hash, [this, &key](const key_type &candidate) { return _equal(candidate, key); });
+    };
+
+    size_type find_insert_index(uint64_t hash) const {
+        for (auto probe = ProbeSequence(hash, _capacity);; probe.next()) {
+            auto match = Group(_ctrl + probe.group_start()).match_empty_or_deleted();
+            if (match) {
+                return probe.group_start() + match.lowest();
+            }
+        }
+    };
+
+    void erase_index(size_type index) {
+        // A slot can only become empty again if its group has another empty slot, because lookups stop at the first
+        // group with an empty slot and may need to continue past this one.
+        size_type group_start = index & ~(Group::width - 1);
+        if (Group(_ctrl + group_start).match_empty()) {
+            _ctrl[index] = flat_table::ctrl_empty;
+            _growth_left += 1;
+        } else {
+            _ctrl[index] = flat_table::ctrl_deleted;
+        }
+        _count -= 1;
+    };
+
+    static size_type max_count_for_capacity(size_type capacity) { return capacity - capacity / 8; };
+
+    void rehash(size_type min_count) {
+        size_type new_capacity = Group::width;
+        while (max_count_for_capacity(new_capacity) < min_count) {
+            new_capacity *= 2;
+        }
+
+        ctrl_t *old_ctrl = _ctrl;
+        Slot *old_slots = _slots;
+        size_type old_capacity = _capacity;
+
+        void *buffer = malloc(new_capacity * (sizeof(ctrl_t) + sizeof(Slot)));
+        _ctrl = static_cast<ctrl_t *>(buffer);
+        _slots = reinterpret_cast<Slot *>(static_cast<char *>(buffer) + new_capacity * sizeof(ctrl_t));
+        _capacity = new_capacity;
+        _growth_left = max_count_for_capacity(new_capacity) - _count;
+        memset(_ctrl, flat_table::ctrl_empty, new_capacity);
+
+        for (size_type i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                uint64_t hash = _hash(old_slots[i].key);
+                size_type index = find_insert_index(hash);
+                _ctrl[index] = h2(hash);
+                _slots[index] = old_slots[i];
+            }
+        }
+
+        free(old_ctrl);
+    };
+
+  public:
+    FlatTable() = default;
+    ~FlatTable() { free(_ctrl); };
+
+    // non-copyable
+    FlatTable(const FlatTable &) = delete;
+    FlatTable &operator=(const FlatTable &) = delete;
+
+    // non-movable
+    FlatTable(FlatTable &&) = delete;
+    FlatTable &operator=(FlatTable &&) = delete;
+
+    // Lookup
+
+    bool empty() const noexcept { return _count == 0; };
+    size_type count() const noexcept { return _count; };
+
+    value_type lookup(const key_type key, key_type *_Nullable found_key) const noexcept {
+        size_type index = find_index(key, _hash(key));
+        if (index == not_found) {
+            if (found_key) {
+                *found_key = key_type();
+            }
+            return value_type();
+        }
+        if (found_key) {
+            *found_key = _slots[index].key;
+        }
+        return _slots[index].value;
+    };
+
+    // Finds a key by a hash computed from some other representation of it, which the predicate compares against the
+    // stored keys. The hash must match what the table's hasher returns for the stored key.
+    template <typename Predicate> key_type find_hashed(uint64_t hash, Predicate predicate) const noexcept {
+        size_type index = find_index_if(hash, predicate);
+        return index == not_found ? key_type() : _slots[index].key;
+    };
+
+    template <typename Body> void for_each(Body body) const {
+        for (size_type i = 0; i < _capacity; ++i) {
+            if (_ctrl[i] >= 0) {
+                body(_slots[i].key, _slots[i].value);
+            }
+        }
+    };
+
+    // Modifying entries
+
+    void reserve(size_type count) {
+        if (count > _count + _growth_left) {
+            rehash(count);
+        }
+    };
+
+    bool insert(const key_type key, const value_type value) {
+        uint64_t hash = _hash(key);
+
+        // replace existing if match
+        size_type index = find_index(key, hash);
+        if (index != not_found) {
+            _slots[index] = {key, value};
+            return false;
+        }
+
+        if (_growth_left == 0) {
+            // grows unless most of the used slots are deleted, in which case they are reclaimed at the same capacity
+            rehash(_count + 1 > max_count_for_capacity(_capacity) / 2 ? _count * 2 + 1 : _count + 1);
+        }
+
+        index = find_insert_index(hash);
+        if (_ctrl[index] == flat_table::ctrl_empty) {
+            _growth_left -= 1;
+        }
+        _ctrl[index] = h2(hash);
+        _slots[index] = {key, value};
+        _count += 1;
+        return true;
+    };
+
+    bool remove(const key_type key) {
+        size_type index = find_index(key, _hash(key));
+        if (index == not_found) {
+            return false;
+        }
+        erase_index(index);
+        return true;
+    };
+
+    // Removes the entries for which the predicate returns true.
+    template <typename Predicate> void remove_if(Predicate predicate) {
+        for (size_type i = 0; i < _capacity; ++i) {
+            if (_ctrl[i] >= 0 && predicate(_slots[i].key, _slots[i].value)) {
+                erase_index(i);
+            }
+        }
+    };
+};
+
+/// A FlatTable of opaque pointers compared by address, with the same interface as UntypedTable.
+class UntypedFlatTable {
+  public:
+    using key_type = const void *_Nonnull;
+    using nullable_key_type = const void *_Nullable;
+    using value_type = const void *_Nullable;
+    using size_type = uint64_t;
+    using entry_callback = void (*)(const key_type, const value_type, void *context);
+
+  private:
+    FlatTable<const void *, const void *> _table;
+
+  public:
+    static UntypedFlatTable *create();
+    static void destroy(UntypedFlatTable *value);
+
+    UntypedFlatTable() = default;
+
+    // Lookup
+    bool empty() const noexcept { return _table.empty(); };
+    size_type count() const noexcept { return _table.count(); };
+    value_type lookup(key_type key, nullable_key_type *_Nullable found_key) const noexcept;
+    void for_each(entry_callback body, void *context) const;
+
+    // Modifiers
+    bool insert(const key_type key, const value_type value);
+    bool remove(const key_type key);
+} SWIFT_UNSAFE_REFERENCE;
+
+} // namespace util
+
+UTIL_ASSUME_NONNULL_END
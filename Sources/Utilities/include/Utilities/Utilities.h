@@ -1,7 +1,9 @@
 #pragma once
 
 #include <Utilities/Base.h>
+#include <Utilities/BlockCompression.h>
 #include <Utilities/CFPointer.h>
+#include <Utilities/FlatTable.h>
 #include <Utilities/FreeDeleter.h>
 #include <Utilities/HashTable.h>
 #include <Utilities/Heap.h>
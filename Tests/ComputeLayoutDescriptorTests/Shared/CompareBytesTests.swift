@@ -0,0 +1,79 @@
+import Foundation
+import Testing
+
+struct Bytes256: Equatable {
+    var first = SIMD64<UInt8>(repeating: 0)
+    var second = SIMD64<UInt8>(repeating: 0)
+    var third = SIMD64<UInt8>(repeating: 0)
+    var fourth = SIMD64<UInt8>(repeating: 0)
+}
+
+@Suite
+struct CompareBytesTests {
+
+    func expectMismatchDetected<Value>(_ value: Value) {
+        #expect(compareValues(value, value, mode: .bitwise) == true)
+
+        for index in 0..<MemoryLayout<Value>.size {
+            var other = value
+            withUnsafeMutableBytes(of: &other) { bytes in
+                bytes[index] ^= 0x80
+            }
+            #expect(compareValues(value, other, mode: .bitwise) == false, "byte \(index)")
+        }
+    }
+
+    @Test
+    func detectsMismatchAtEveryOffset() async {
+        await #expect(processExitsWith: .success) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+
+            expectMismatchDetected(SIMD8<UInt8>(repeating: 1))
+            expectMismatchDetected(SIMD16<UInt8>(repeating: 1))
+            expectMismatchDetected(SIMD32<UInt8>(repeating: 1))
+            expectMismatchDetected(SIMD64<UInt8>(repeating: 1))
+            expectMismatchDetected((SIMD32<UInt8>(repeating: 1), UInt8(1), UInt16(2)))
+            expectMismatchDetected(Bytes256())
+        }
+    }
+
+    // Prints the cost per comparison of each size, one line per size
+    static func measureCompareBytes(iterations: Int = 100_000) {
+        func measure<Value>(_ value: Value) {
+            let clock = ContinuousClock()
+            var result = true
+            let duration = clock.measure {
+                for _ in 0..<iterations {
+                    result = result && compareValues(value, value, mode: .bitwise)
+                }
+            }
+            #expect(result == true)
+            print("\(MemoryLayout<Value>.size) bytes: \(duration / iterations)")
+        }
+
+        measure(SIMD16<UInt8>(repeating: 1))
+        measure(SIMD32<UInt8>(repeating: 1))
+        measure(SIMD64<UInt8>(repeating: 1))
+        measure(Bytes256())
+    }
+
+    @Test(.enabled(if: ProcessInfo.processInfo.environment[benchmarksEnvironmentVariable] != nil))
+    func benchmarkCompareBytes() async throws {
+        let scalar = try await #require(processExitsWith: .success, observing: [\.standardOutputContent]) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+            setenv(vectorCompareEnvironmentVariable, "0", 1)
+            CompareBytesTests.measureCompareBytes()
+        }
+        let vector = try await #require(processExitsWith: .success, observing: [\.standardOutputContent]) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+            CompareBytesTests.measureCompareBytes()
+        }
+
+        let scalarLines = String(decoding: scalar.standardOutputContent, as: UTF8.self).split(separator: "\n")
+        let vectorLines = String(decoding: vector.standardOutputContent, as: UTF8.self).split(separator: "\n")
+        for (scalarLine, vectorLine) in zip(scalarLines, vectorLines) {
+            print("compare \(scalarLine) scalar, \(vectorLine.split(separator: ": ").last ?? "") vector")
+        }
+    }
+
+}
@@ -0,0 +1,150 @@
+import Foundation
+import Testing
+
+#if !COMPATIBILITY_TESTS
+
+final class CachedReference {}
+
+struct CachedLayoutValue {
+    var count: Int
+    var scale: Double
+    var reference: CachedReference
+}
+
+struct CachedLayoutFlags {
+    var first: Int8
+    var second: Int16
+}
+
+struct CachedLayoutRecord {
+    var flags: CachedLayoutFlags
+    var count: Int
+}
+
+@Suite(.serialized)
+struct LayoutCacheTests {
+
+    static let cachePath = NSTemporaryDirectory() + "LayoutCacheTests.cache"
+
+    // FileHeader and FileRecord in LayoutCache.cpp
+    static let fileHeaderSize = 20
+    static let fileEntryCountOffset = 16
+    static let fileRecordSize = 56
+    static let recordDependenciesOffset = 20
+    static let recordLengthOffset = 52
+
+    /// Changes the digest of the images each cached layout was built from, as if their field types had been rebuilt,
+    /// and returns the number of changed records.
+    static func changeDependencies(atPath path: String) -> Int {
+        guard var bytes = FileManager.default.contents(atPath: path).map({ Array($0) }),
+            bytes.count >= fileHeaderSize
+        else {
+            return 0
+        }
+        func readUInt32(at position: Int) -> Int {
+            (0..<4).reduce(0) { $0 | Int(bytes[position + $1]) << ($1 * 8) }
+        }
+
+        let count = readUInt32(at: fileEntryCountOffset)
+        var position = fileHeaderSize
+        for _ in 0..<count {
+            guard position + fileRecordSize <= bytes.count else {
+                return 0
+            }
+            bytes[position + recordDependenciesOffset] ^= 0xff
+            position += fileRecordSize + readUInt32(at: position + recordLengthOffset)
+        }
+        guard FileManager.default.createFile(atPath: path, contents: Data(bytes)) else {
+            return 0
+        }
+        return count
+    }
+
+    @Test
+    func layoutsArePersistedAcrossLaunches() async {
+        try? FileManager.default.removeItem(atPath: Self.cachePath)
+
+        await #expect(processExitsWith: .success) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+            setenv(layoutCacheEnvironmentVariable, LayoutCacheTests.cachePath, 1)
+
+            let reference = CachedReference()
+            let value = CachedLayoutValue(count: 1, scale: 2.0, reference: reference)
+            let flags = CachedLayoutFlags(first: 1, second: 2)
+            #expect(compareValues(value, value, mode: .bitwise) == true)
+            #expect(compareValues(flags, flags, mode: .bitwise) == true)
+        }
+
+        let attributes = try? FileManager.default.attributesOfItem(atPath: Self.cachePath)
+        #expect(((attributes?[.size] as? NSNumber)?.intValue ?? 0) > 0)
+
+        await #expect(processExitsWith: .success) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+            setenv(layoutCacheEnvironmentVariable, LayoutCacheTests.cachePath, 1)
+
+            let reference = CachedReference()
+            let value = CachedLayoutValue(count: 1, scale: 2.0, reference: reference)
+            let other = CachedLayoutValue(count: 2, scale: 2.0, reference: reference)
+            #expect(compareValues(value, value, mode: .bitwise) == true)
+            #expect(compareValues(value, other, mode: .bitwise) == false)
+
+            let flags = CachedLayoutFlags(first: 1, second: 2)
+            #expect(compareValues(flags, flags, mode: .bitwise) == true)
+            #expect(compareValues(flags, CachedLayoutFlags(first: 1, second: 3), mode: .bitwise) == false)
+            #expect(compareValues(flags, CachedLayoutFlags(first: 2, second: 2), mode: .bitwise) == false)
+        }
+
+        try? FileManager.default.removeItem(atPath: Self.cachePath)
+    }
+
+    @Test
+    func layoutsMissWhenFieldTypeImagesChange() async {
+        try? FileManager.default.removeItem(atPath: Self.cachePath)
+
+        await #expect(processExitsWith: .success) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+            setenv(layoutCacheEnvironmentVariable, LayoutCacheTests.cachePath, 1)
+
+            let record = CachedLayoutRecord(flags: CachedLayoutFlags(first: 1, second: 2), count: 3)
+            #expect(compareValues(record, record, mode: .bitwise) == true)
+        }
+
+        // the same binaries restore the layout instead of building it
+        await #expect(processExitsWith: .success) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+            setenv(layoutCacheEnvironmentVariable, LayoutCacheTests.cachePath, 1)
+            setenv(printLayoutsEnvironmentVariable, "1", 1)
+
+            let record = CachedLayoutRecord(flags: CachedLayoutFlags(first: 1, second: 2), count: 3)
+            var output = ""
+            let equal = await reprintingStandardError(to: &output) {
+                compareValues(record, record, mode: .bitwise)
+            }
+            #expect(equal == true)
+            #expect(!output.contains("CachedLayoutRecord"))
+        }
+
+        #expect(Self.changeDependencies(atPath: Self.cachePath) > 0)
+
+        // the type's own signature is unchanged, but the layout must be built again
+        await #expect(processExitsWith: .success) {
+            setenv(asyncLayoutsEnvironmentVariable, "0", 1)
+            setenv(layoutCacheEnvironmentVariable, LayoutCacheTests.cachePath, 1)
+            setenv(printLayoutsEnvironmentVariable, "1", 1)
+
+            let record = CachedLayoutRecord(flags: CachedLayoutFlags(first: 1, second: 2), count: 3)
+            let other = CachedLayoutRecord(flags: CachedLayoutFlags(first: 1, second: 2), count: 4)
+            var output = ""
+            let equal = await reprintingStandardError(to: &output) {
+                compareValues(record, other, mode: .bitwise)
+            }
+            #expect(equal == false)
+            #expect(output.contains("CachedLayoutRecord"))
+        }
+
+        try? FileManager.default.removeItem(atPath: Self.cachePath)
+    }
+
+}
+
+#endif
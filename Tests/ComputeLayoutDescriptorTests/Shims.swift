@@ -3,3 +3,6 @@
 let prefetchLayoutsEnvironmentVariable = "IAG_PREFETCH_LAYOUTS"
 let asyncLayoutsEnvironmentVariable = "IAG_ASYNC_LAYOUTS"
 let printLayoutsEnvironmentVariable = "IAG_PRINT_LAYOUTS"
+let layoutCacheEnvironmentVariable = "IAG_LAYOUT_CACHE"
+let vectorCompareEnvironmentVariable = "IAG_VECTOR_COMPARE"
+let benchmarksEnvironmentVariable = "IAG_BENCHMARKS"
@@ -364,6 +364,33 @@ struct AttributeTests {
                 #expect(foundOutput == true)
             }
         }
+
+        @Test
+        func searchVisitsEachInputOnce() {
+            withGraph {
+                // a diamond lattice, where every attribute is reachable along many paths
+                let width = 100
+                let depth = 50
+                let roots = (0..<width).map { Attribute(value: $0) }
+                var layer = roots
+                for _ in 0..<depth {
+                    let nextLayer = (0..<width).map { Attribute(value: $0) }
+                    for (index, attribute) in nextLayer.enumerated() {
+                        attribute.addInput(layer[index], options: [], token: 0)
+                        attribute.addInput(layer[(index + 1) % width], options: [], token: 0)
+                    }
+                    layer = nextLayer
+                }
+
+                var visitedCount = 0
+                let found = layer[0].breadthFirstSearch(options: [.searchInputs]) { candidate in
+                    visitedCount += 1
+                    return candidate == roots[width - 1].identifier
+                }
+                #expect(found == true)
+                #expect(visitedCount <= width * (depth + 1))
+            }
+        }
     }
 
     @Suite
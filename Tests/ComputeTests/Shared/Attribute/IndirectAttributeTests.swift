@@ -68,6 +68,137 @@ struct IndirectAttributeTests {
                 #expect(foundSource2 == false)
             }
         }
+
+        @Test
+        func sourceWithManyIndirectAttributes() {
+            withGraph {
+                let source1 = Attribute(value: 1)
+                let source2 = Attribute(value: 2)
+                let indirects = (0..<200).map { _ in IndirectAttribute(source: source1) }
+
+                for (index, indirect) in indirects.enumerated() where index % 2 == 0 {
+                    indirect.source = source2
+                }
+                for indirect in indirects.prefix(10) {
+                    indirect.resetSource()
+                }
+
+                for (index, indirect) in indirects.enumerated() {
+                    let expectedSource = index < 10 || index % 2 == 1 ? source1 : source2
+                    #expect(indirect.source.identifier == expectedSource.identifier)
+
+                    let foundIndirect = expectedSource.breadthFirstSearch(options: [.searchOutputs]) { candidate in
+                        return candidate == indirect.identifier
+                    }
+                    #expect(foundIndirect == true)
+                }
+            }
+        }
+
+        @Test
+        func sourceWithDuplicateOutputs() {
+            withGraph {
+                let source1 = Attribute(value: 1)
+                let source2 = Attribute(value: 2)
+                let indirects = (0..<100).map { _ in IndirectAttribute(source: source1) }
+
+                // source1 is both the source and the dependency, so each indirect is its output twice
+                for indirect in indirects {
+                    indirect.dependency = source1.identifier
+                }
+
+                // interleave removals with insertions while the outputs are indexed
+                for (index, indirect) in indirects.enumerated() {
+                    switch index % 3 {
+                    case 0:
+                        indirect.source = source2
+                        indirect.dependency = nil
+                    case 1:
+                        indirect.source = source2
+                        indirect.resetSource()
+                    default:
+                        indirect.dependency = nil
+                        indirect.dependency = source1.identifier
+                    }
+                }
+
+                for (index, indirect) in indirects.enumerated() {
+                    let foundFromSource1 = source1.breadthFirstSearch(options: [.searchOutputs]) { candidate in
+                        return candidate == indirect.identifier
+                    }
+                    #expect(foundFromSource1 == (index % 3 != 0))
+
+                    let foundFromSource2 = source2.breadthFirstSearch(options: [.searchOutputs]) { candidate in
+                        return candidate == indirect.identifier
+                    }
+                    #expect(foundFromSource2 == (index % 3 == 0))
+                }
+            }
+        }
+    }
+
+    @Suite
+    struct ResolveTests {
+        struct Pair: Equatable {
+            var first: Int
+            var second: Int
+        }
+
+        @Test
+        func valueFollowsSourceChangesThroughOffsetChain() {
+            withGraph {
+                let source1 = Attribute(value: Pair(first: 1, second: 2))
+                let source2 = Attribute(value: Pair(first: 3, second: 4))
+                let indirect = IndirectAttribute(source: source1)
+                let second = indirect.attribute[keyPath: \.second]
+
+                // resolving repeatedly reuses the previously resolved source
+                #expect(second.value == 2)
+                #expect(second.value == 2)
+
+                indirect.source = source2
+                #expect(second.value == 4)
+
+                indirect.resetSource()
+                #expect(second.value == 2)
+            }
+        }
+
+        #if !COMPATIBILITY_TESTS
+        @Test
+        func resolvedSourcesAreOnlyDiscardedByChangesInTheirGraph() {
+            let graph = Graph()
+            let otherGraph = Graph()
+            let subgraph = Subgraph(graph: graph)
+            let otherSubgraph = Subgraph(graph: otherGraph)
+
+            let (indirect, second, source2) = subgraph.apply {
+                let indirect = IndirectAttribute(source: Attribute(value: Pair(first: 1, second: 2)))
+                return (indirect, indirect.attribute[keyPath: \.second], Attribute(value: Pair(first: 3, second: 4)))
+            }
+            let (otherIndirect, otherSource) = otherSubgraph.apply {
+                (IndirectAttribute(source: Attribute(value: 1)), Attribute(value: 2))
+            }
+
+            func missesReading(_ expected: Int) -> UInt64 {
+                let misses = graph.counter(for: .indirectResolutionMisses)
+                #expect(second.value == expected)
+                return graph.counter(for: .indirectResolutionMisses) - misses
+            }
+
+            #expect(second.value == 2)
+            let hits = graph.counter(for: .indirectResolutionHits)
+            let unchangedMisses = missesReading(2)
+            #expect(graph.counter(for: .indirectResolutionHits) > hits)
+
+            otherIndirect.source = otherSource
+            #expect(missesReading(2) == unchangedMisses)
+
+            indirect.source = source2
+            #expect(missesReading(4) > unchangedMisses)
+            #expect(missesReading(4) == unchangedMisses)
+        }
+        #endif
     }
 
     @Suite
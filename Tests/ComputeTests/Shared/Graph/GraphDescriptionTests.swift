@@ -364,3 +364,102 @@ struct GraphDescriptionTests {
     }
 }
 #endif
+
+#if !COMPATIBILITY_TESTS
+struct GraphExportTests {
+    struct TestRule: Rule {
+        @Attribute var input: Int
+        var value: Int { input + 1 }
+    }
+
+    func exportedData(_ body: (Int32) -> Bool) throws -> Data {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        FileManager.default.createFile(atPath: url.path, contents: nil)
+        defer {
+            try? FileManager.default.removeItem(at: url)
+        }
+
+        let fileHandle = try FileHandle(forWritingTo: url)
+        #expect(body(fileHandle.fileDescriptor))
+        try fileHandle.close()
+
+        return try Data(contentsOf: url)
+    }
+
+    @Test
+    func exportsNodesAndEdgesAsJSON() throws {
+        let graph = Graph()
+        let subgraph = Subgraph(graph: graph)
+        let output = subgraph.apply {
+            Attribute(TestRule(input: Attribute(value: 1)))
+        }
+        #expect(output.value == 2)
+
+        let data = try exportedData { graph.exportJSON(to: $0, options: .includeValues) }
+        let json = try #require(try JSONSerialization.jsonObject(with: data) as? [String: Any])
+        #expect(json["version"] as? Int == 2)
+
+        let graphs = try #require(json["graphs"] as? [[String: Any]])
+        #expect(graphs.count == 1)
+        #expect((graphs[0]["nodes"] as? [[String: Any]])?.count == 2)
+        #expect((graphs[0]["types"] as? [[String: Any]])?.count == 2)
+
+        let edges = try #require(graphs[0]["edges"] as? [[String: Any]])
+        #expect(edges.count == 1)
+        #expect(Set([edges[0]["src"] as? Int, edges[0]["dst"] as? Int]) == [0, 1])
+    }
+
+    @Test
+    func exportsDot() throws {
+        let graph = Graph()
+        let subgraph = Subgraph(graph: graph)
+        let output = subgraph.apply {
+            Attribute(TestRule(input: Attribute(value: 1)))
+        }
+        #expect(output.value == 2)
+
+        let data = try exportedData { graph.exportDot(to: $0) }
+        let dot = try #require(String(data: data, encoding: .utf8))
+        #expect(dot.hasPrefix("digraph {\n"))
+        #expect(dot.contains(" -> _"))
+        #expect(dot.hasSuffix("}\n"))
+    }
+
+    @Test
+    func writesSnapshot() throws {
+        let graph = Graph()
+        let subgraph = Subgraph(graph: graph)
+        let output = subgraph.apply {
+            Attribute(TestRule(input: Attribute(value: 1)))
+        }
+        #expect(output.value == 2)
+
+        let data = try exportedData { graph.writeSnapshot(to: $0) }
+        try data.withUnsafeBytes { buffer in
+            let header = buffer.loadUnaligned(as: IAGGraphSnapshotHeader.self)
+            let magic = withUnsafeBytes(of: header.magic) { String(decoding: $0.prefix(7), as: UTF8.self) }
+            #expect(magic == "IAGSNAP")
+            #expect(header.version == UInt32(IAG_GRAPH_SNAPSHOT_VERSION))
+            #expect(header.file_size == UInt64(buffer.count))
+
+            let nodes = header.sections.3
+            #expect(nodes.count == 2)
+            #expect(nodes.record_size == UInt32(MemoryLayout<IAGGraphSnapshotNode>.size))
+
+            let inputEdges = header.sections.4
+            #expect(inputEdges.count == 1)
+            let inputEdge = buffer.loadUnaligned(
+                fromByteOffset: Int(inputEdges.offset),
+                as: IAGGraphSnapshotInputEdge.self
+            )
+            let source = try #require(inputEdge.node < nodes.count ? inputEdge.node : nil)
+            let sourceNode = buffer.loadUnaligned(
+                fromByteOffset: Int(nodes.offset) + Int(source) * Int(nodes.record_size),
+                as: IAGGraphSnapshotNode.self
+            )
+            #expect(sourceNode.attribute == inputEdge.attribute)
+            #expect(sourceNode.output_edge_count == 1)
+        }
+    }
+}
+#endif
@@ -167,4 +167,191 @@ struct GraphTests {
             }
         }
     }
+
+    #if !COMPATIBILITY_TESTS
+    @Suite
+    struct ProfileTests {
+        struct TestRule: Rule {
+            @Attribute var input: Int
+            var value: Int { input + 1 }
+        }
+
+        @Test
+        func recordsUpdatesPerAttributeType() {
+            let graph = Graph()
+            let subgraph = Subgraph(graph: graph)
+
+            let (input, output) = subgraph.apply {
+                let input = Attribute(value: 1)
+                return (input, Attribute(TestRule(input: input)))
+            }
+
+            #expect(graph.profileEntries.isEmpty)
+
+            Graph.startProfiling(graph)
+            #expect(output.value == 2)
+            input.value = 2
+            #expect(output.value == 3)
+            Graph.stopProfiling(graph)
+
+            input.value = 3
+            #expect(output.value == 4)
+
+            let entries = graph.profileEntries
+            #expect(entries.count == 1)
+            let entry = entries[0]
+            #expect(entry.update_count == 2)
+            #expect(entry.max_duration <= entry.total_duration)
+            let histogramCount = withUnsafeBytes(of: entry.histogram) { buffer in
+                buffer.bindMemory(to: UInt64.self).reduce(0, +)
+            }
+            #expect(histogramCount == 2)
+
+            Graph.resetProfile()
+            #expect(graph.profileEntries.isEmpty)
+        }
+
+        @Test
+        func mergesEntriesOfRemovedSubgraphs() throws {
+            let graph = Graph()
+            Graph.startProfiling(graph)
+
+            for value in 0..<3 {
+                let subgraph = Subgraph(graph: graph)
+                let output = subgraph.apply {
+                    Attribute(TestRule(input: Attribute(value: value)))
+                }
+                #expect(output.value == value + 1)
+
+                let entries = graph.profileEntries
+                #expect(entries.filter { $0.subgraph_id != 0 }.count == 1)
+
+                subgraph.invalidate()
+            }
+            Graph.stopProfiling(graph)
+
+            let entries = graph.profileEntries
+            try #require(entries.count == 1)
+            #expect(entries[0].subgraph_id == 0)
+            #expect(entries[0].update_count == 3)
+        }
+    }
+
+    @Suite
+    struct DataTableTests {
+        struct TestRule: Rule {
+            @Attribute var input: Int
+            var value: Int { input + 1 }
+        }
+
+        static func runOnNewThread(_ body: @escaping () -> Void) {
+            let finished = DispatchSemaphore(value: 0)
+            let thread = Thread {
+                body()
+                finished.signal()
+            }
+            thread.start()
+            finished.wait()
+        }
+
+        static func makeSubgraph(graph: Graph, attributeCount: Int) -> Subgraph {
+            let subgraph = Subgraph(graph: graph)
+            subgraph.apply {
+                let input = Attribute(value: 1)
+                for _ in 0..<attributeCount {
+                    let _ = Attribute(TestRule(input: input))
+                }
+            }
+            return subgraph
+        }
+
+        @Test
+        func cachedPagesAreCountedAsFree() async {
+            await #expect(processExitsWith: .success) {
+                let graph = Graph()
+                let usedBytes = graph.counter(for: .dataBytes)
+                let cachedBytes = graph.counter(for: .dataCachedBytes)
+
+                nonisolated(unsafe) var subgraph: Subgraph? = nil
+                DataTableTests.runOnNewThread {
+                    subgraph = DataTableTests.makeSubgraph(graph: graph, attributeCount: 1)
+                }
+
+                // The first allocation on a thread reserves a whole page cache, of which only the page handed to the
+                // zone is in use.
+                let usedDelta = graph.counter(for: .dataBytes) - usedBytes
+                #expect(usedDelta > 0)
+                #expect(usedDelta + graph.counter(for: .dataCachedBytes) - cachedBytes == 16 * 512)
+                withExtendedLifetime(subgraph) {}
+            }
+        }
+
+        @Test
+        func releasedPagesAreReusedAcrossThreads() async {
+            await #expect(processExitsWith: .success) {
+                let graph = Graph()
+                let usedBytes = graph.counter(for: .dataBytes)
+
+                nonisolated(unsafe) var subgraph: Subgraph? = nil
+                DataTableTests.runOnNewThread {
+                    subgraph = DataTableTests.makeSubgraph(graph: graph, attributeCount: 4000)
+                }
+                let allocatedBytes = graph.counter(for: .dataBytes) - usedBytes
+                #expect(allocatedBytes > 64 * 1024)
+
+                // Invalidating the subgraph on the main thread returns its pages to the table
+                subgraph?.invalidate()
+                subgraph = nil
+                #expect(graph.counter(for: .dataBytes) == usedBytes)
+                let mappedBytes = graph.counter(for: .dataMappedBytes)
+
+                DataTableTests.runOnNewThread {
+                    subgraph = DataTableTests.makeSubgraph(graph: graph, attributeCount: 4000)
+                }
+                #expect(graph.counter(for: .dataBytes) - usedBytes == allocatedBytes)
+
+                // At most one further page map may be needed for the page cache the first thread still holds
+                #expect(graph.counter(for: .dataMappedBytes) - mappedBytes <= 64 * 512)
+                withExtendedLifetime(subgraph) {}
+            }
+        }
+
+        typealias Words4 = (UInt64, UInt64, UInt64, UInt64)
+        typealias Words16 = (Words4, Words4, Words4, Words4)
+
+        @Test
+        func reservedDataSpaceGrowsInPlace() async {
+            // The table is created when the library loads, so the flag has to be inherited by the exit test process
+            setenv(reserveDataSpaceEnvironmentVariable, "1", 1)
+            defer { unsetenv(reserveDataSpaceEnvironmentVariable) }
+
+            await #expect(processExitsWith: .success) {
+                let graph = Graph()
+                let subgraph = Subgraph(graph: graph)
+                let baseAddress = Graph.vmRegionBaseAddress
+                #expect(baseAddress != nil)
+
+                // The region starts at 1MB and grows fourfold, so mapping more than 16MB of pages commits it three
+                // times. Values of 128 bytes are still stored inline in their nodes.
+                let attributes = subgraph.apply {
+                    var attributes: [Attribute<Words16>] = []
+                    while graph.counter(for: .dataMappedBytes) <= 16 << 20 {
+                        let words: Words4 = (UInt64(attributes.count), 0, 0, 0)
+                        attributes.append(Attribute(value: (words, words, words, words)))
+                        if attributes.count.isMultiple(of: 4096) {
+                            #expect(Graph.vmRegionBaseAddress == baseAddress)
+                        }
+                    }
+                    return attributes
+                }
+                #expect(Graph.vmRegionBaseAddress == baseAddress)
+
+                for (index, attribute) in attributes.enumerated() where index.isMultiple(of: 97) {
+                    #expect(attribute.value.0.0 == UInt64(index))
+                    #expect(attribute.value.3.0 == UInt64(index))
+                }
+            }
+        }
+    }
+    #endif
 }
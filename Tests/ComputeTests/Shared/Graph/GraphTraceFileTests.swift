@@ -0,0 +1,359 @@
+import Foundation
+import Testing
+
+#if !COMPATIBILITY_TESTS
+
+@Suite
+struct GraphTraceFileTests {
+
+    struct TestRule: Rule {
+        @Attribute var input: Int
+        var value: Int { input + 1 }
+    }
+
+    static let formatField: UInt64 = 7
+    static let beginNodeUpdateEvent: UInt64 = 5
+    static let endNodeUpdateEvent: UInt64 = 6
+
+    static let eventTypeField: UInt64 = 1
+    static let timestampField: UInt64 = 2
+    static let payload1Field: UInt64 = 3
+    static let timestampDeltaField: UInt64 = 11
+    static let payload1DeltaField: UInt64 = 12
+
+    @Test
+    func compactCompressedTraceDecodes() async {
+        await #expect(processExitsWith: .success) {
+            let directory = NSTemporaryDirectory() + "GraphTraceFileTests-\(getpid())/"
+            try? FileManager.default.createDirectory(atPath: directory, withIntermediateDirectories: true)
+            defer {
+                try? FileManager.default.removeItem(atPath: directory)
+            }
+            setenv("TMPDIR", directory, 1)
+            setenv("IAG_TRACE_FILE", "compact", 1)
+
+            let graph = Graph()
+            Graph.__startTracing(graph, flags: [.enabled, .full, .compact, .compressed])
+
+            let subgraph = Subgraph(graph: graph)
+            let outputs = subgraph.apply {
+                (0..<5000).map { Attribute(TestRule(input: Attribute(value: $0))) }
+            }
+
+            // updating in reverse makes consecutive attribute payloads decrease
+            for output in outputs.reversed() {
+                #expect(output.value > 0)
+            }
+            Graph.__stopTracing(graph)
+
+            guard let file = try? TraceFile(contentsOf: directory + "compact-0001.iag-trace") else {
+                Issue.record("missing trace file")
+                return
+            }
+            #expect(file.isCompressed)
+
+            guard let frames = file.frames() else {
+                Issue.record("malformed frames")
+                return
+            }
+            #expect(frames.count > 1)
+            #expect(frames.contains { $0.isCompressed })
+
+            guard let messages = file.messages(), let fields = TraceFile.fields(messages[...]),
+                let events = TraceFile.compactEvents(fields)
+            else {
+                Issue.record("malformed messages")
+                return
+            }
+
+            // the trace starts with a format message recording version 2
+            #expect(fields.first?.number == Self.formatField)
+            #expect(fields.first.flatMap { TraceFile.fields($0.bytes) }?.first?.value == 2)
+            #expect(!fields.contains { $0.number == 1 })
+
+            var timestamps: [UInt64] = []
+            var timestamp: UInt64 = 0
+            var attribute: Int64 = 0
+            var updatedAttributes: [UInt32] = []
+            for event in events {
+                if let delta = event.field(Self.timestampDeltaField) {
+                    timestamps.append(delta.value)
+                    timestamp += delta.value
+                }
+                if let delta = event.field(Self.payload1DeltaField) {
+                    // zigzag decoded
+                    attribute += Int64(bitPattern: delta.value >> 1) ^ -Int64(bitPattern: delta.value & 1)
+                }
+                if event.type == Self.beginNodeUpdateEvent || event.type == Self.endNodeUpdateEvent {
+                    #expect(event.field(Self.eventTypeField) == nil)
+                    #expect(event.field(Self.timestampField) == nil)
+                    #expect(event.field(Self.payload1Field) == nil)
+                }
+                if event.type == Self.beginNodeUpdateEvent {
+                    updatedAttributes.append(UInt32(attribute))
+                }
+            }
+
+            #expect(updatedAttributes == outputs.reversed().map { $0.identifier.rawValue })
+
+            // only the first timestamp is absolute, the others are ticks since the previous event
+            #expect(timestamps.count > 1)
+            #expect(timestamp > 0)
+            #expect(timestamps.dropFirst().allSatisfy { $0 < timestamps.first ?? 0 })
+        }
+    }
+
+    // the clock behind the graph's timestamps, in nanoseconds
+    static func monotonicNanoseconds() -> UInt64 {
+        #if canImport(Darwin)
+        clock_gettime_nsec_np(CLOCK_UPTIME_RAW)
+        #else
+        var time = timespec()
+        clock_gettime(CLOCK_MONOTONIC, &time)
+        return UInt64(time.tv_sec) * 1_000_000_000 + UInt64(time.tv_nsec)
+        #endif
+    }
+
+    @Test
+    func compactTimestampsAreNanoseconds() async {
+        await #expect(processExitsWith: .success) {
+            let directory = NSTemporaryDirectory() + "GraphTraceFileTests-\(getpid())/"
+            try? FileManager.default.createDirectory(atPath: directory, withIntermediateDirectories: true)
+            defer {
+                try? FileManager.default.removeItem(atPath: directory)
+            }
+            setenv("TMPDIR", directory, 1)
+            setenv("IAG_TRACE_FILE", "timestamps", 1)
+
+            let graph = Graph()
+            let subgraph = Subgraph(graph: graph)
+            let (first, second) = subgraph.apply {
+                (Attribute(TestRule(input: Attribute(value: 1))), Attribute(TestRule(input: Attribute(value: 2))))
+            }
+
+            let start = GraphTraceFileTests.monotonicNanoseconds()
+            Graph.__startTracing(graph, flags: [.enabled, .full, .compact])
+            #expect(first.value == 2)
+            usleep(20_000)
+            #expect(second.value == 3)
+            Graph.__stopTracing(graph)
+            let end = GraphTraceFileTests.monotonicNanoseconds()
+
+            guard let messages = try? TraceFile(contentsOf: directory + "timestamps-0001.iag-trace").messages(),
+                let fields = TraceFile.fields(messages[...]), let events = TraceFile.compactEvents(fields)
+            else {
+                Issue.record("missing or malformed trace file")
+                return
+            }
+
+            var timestamp: UInt64 = 0
+            var timestamps: [UInt64] = []
+            var updateTimestamps: [UInt64] = []
+            for event in events {
+                // an omitted delta is zero, or the event has no timestamp
+                timestamp += event.field(Self.timestampDeltaField)?.value ?? 0
+                if timestamp > 0 {
+                    timestamps.append(timestamp)
+                }
+                if event.type == Self.beginNodeUpdateEvent {
+                    updateTimestamps.append(timestamp)
+                }
+            }
+
+            // timestamps accumulate to readings of the same clock as the test's, in the same unit
+            #expect(timestamps.count > 2)
+            #expect(timestamps.allSatisfy { $0 >= start && $0 <= end })
+            #expect(updateTimestamps.count == 2)
+            if updateTimestamps.count == 2 {
+                #expect(updateTimestamps[1] - updateTimestamps[0] >= 20_000_000)
+            }
+        }
+    }
+
+    @Suite
+    struct WriterTests {
+
+        static let attributeCount = 4000
+        static let rounds = 20
+
+        // the writer queues at most four 64 KiB buffers
+        static let ringCapacity = 4 * 64 * 1024
+
+        static let beginNodeUpdateField = 64 + GraphTraceFileTests.beginNodeUpdateEvent
+
+        static func makeAttributes() -> (inputs: [Attribute<Int>], outputs: [Attribute<Int>]) {
+            let inputs = (0..<attributeCount).map { Attribute(value: $0) }
+            return (inputs, inputs.map { Attribute(TestRule(input: $0)) })
+        }
+
+        static func update(_ inputs: [Attribute<Int>], _ outputs: [Attribute<Int>], rounds: ClosedRange<Int>) {
+            for round in rounds {
+                for input in inputs {
+                    input.value = round
+                }
+                for output in outputs {
+                    #expect(output.value > 0)
+                }
+            }
+        }
+
+        static func beginNodeUpdateCount(_ messages: [UInt8]?) -> Int? {
+            guard let messages, let fields = TraceFile.fields(messages[...]) else {
+                return nil
+            }
+            return fields.filter { $0.number == beginNodeUpdateField }.count
+        }
+
+        static func descriptor(of path: String) -> Int32? {
+            var target = stat()
+            guard stat(path, &target) == 0 else {
+                return nil
+            }
+            for descriptor in 0..<getdtablesize() {
+                var info = stat()
+                if fstat(descriptor, &info) == 0 && info.st_dev == target.st_dev && info.st_ino == target.st_ino {
+                    return descriptor
+                }
+            }
+            return nil
+        }
+
+        @Test
+        func fullRingBlocksUntilBuffersAreWritten() async {
+            await #expect(processExitsWith: .success) {
+                let directory = NSTemporaryDirectory() + "TraceWriterTests-\(getpid())/"
+                try? FileManager.default.createDirectory(atPath: directory, withIntermediateDirectories: true)
+                defer {
+                    try? FileManager.default.removeItem(atPath: directory)
+                }
+                setenv("TMPDIR", directory, 1)
+                setenv("IAG_TRACE_FILE", "stalled", 1)
+
+                let graph = Graph()
+                Graph.__startTracing(graph, flags: [.enabled, .full, .compact])
+
+                let subgraph = Subgraph(graph: graph)
+                let (inputs, outputs) = subgraph.apply { WriterTests.makeAttributes() }
+                WriterTests.update(inputs, outputs, rounds: 0...0)
+                graph.__syncTracing()
+
+                let path = directory + "stalled-0001.iag-trace"
+                guard let traceDescriptor = WriterTests.descriptor(of: path) else {
+                    Issue.record("missing trace file descriptor")
+                    return
+                }
+
+                // Swap the trace file for a pipe that isn't read until the updates have had time to fill the ring
+                let pipe = Pipe()
+                dup2(pipe.fileHandleForWriting.fileDescriptor, traceDescriptor)
+                try? pipe.fileHandleForWriting.close()
+                let readHandle = pipe.fileHandleForReading
+
+                let finished = DispatchSemaphore(value: 0)
+                let drained = DispatchSemaphore(value: 0)
+                nonisolated(unsafe) var finishedWhileStalled = true
+                nonisolated(unsafe) var pipedBytes: [UInt8] = []
+                let thread = Thread {
+                    finishedWhileStalled = finished.wait(timeout: .now() + 1) == .success
+                    // reads until the writer closes its end when tracing stops
+                    pipedBytes = Array(readHandle.readDataToEndOfFile())
+                    drained.signal()
+                }
+                thread.start()
+
+                WriterTests.update(inputs, outputs, rounds: 1...WriterTests.rounds)
+                finished.signal()
+                Graph.__stopTracing(graph)
+                drained.wait()
+
+                #expect(!finishedWhileStalled)
+                #expect(pipedBytes.count > WriterTests.ringCapacity)
+
+                // every buffer queued while the writer was stalled reaches the pipe, in order
+                let fileCount = WriterTests.beginNodeUpdateCount(try? TraceFile(contentsOf: path).messages())
+                let pipedCount = WriterTests.beginNodeUpdateCount(pipedBytes)
+                #expect(fileCount == WriterTests.attributeCount)
+                #expect(pipedCount == WriterTests.attributeCount * WriterTests.rounds)
+            }
+        }
+
+        @Test
+        func stoppingWritesQueuedBuffers() async {
+            await #expect(processExitsWith: .success) {
+                let directory = NSTemporaryDirectory() + "TraceWriterTests-\(getpid())/"
+                try? FileManager.default.createDirectory(atPath: directory, withIntermediateDirectories: true)
+                defer {
+                    try? FileManager.default.removeItem(atPath: directory)
+                }
+                setenv("TMPDIR", directory, 1)
+                setenv("IAG_TRACE_FILE", "stopped", 1)
+
+                let graph = Graph()
+                Graph.__startTracing(graph, flags: [.enabled, .full, .compact, .compressed])
+
+                let subgraph = Subgraph(graph: graph)
+                let (inputs, outputs) = subgraph.apply { WriterTests.makeAttributes() }
+                WriterTests.update(inputs, outputs, rounds: 0...WriterTests.rounds)
+
+                // no sync, stopping waits for the writer thread to drain the ring
+                Graph.__stopTracing(graph)
+
+                guard let file = try? TraceFile(contentsOf: directory + "stopped-0001.iag-trace"),
+                    let frames = file.frames()
+                else {
+                    Issue.record("missing or truncated trace file")
+                    return
+                }
+                #expect(frames.count > WriterTests.ringCapacity / (64 * 1024))
+                #expect(
+                    WriterTests.beginNodeUpdateCount(file.messages())
+                        == WriterTests.attributeCount * (WriterTests.rounds + 1)
+                )
+            }
+        }
+
+        @Test
+        func synchronousWritesReachFileBeforeReturning() async {
+            await #expect(processExitsWith: .success) {
+                let directory = NSTemporaryDirectory() + "TraceWriterTests-\(getpid())/"
+                try? FileManager.default.createDirectory(atPath: directory, withIntermediateDirectories: true)
+                defer {
+                    try? FileManager.default.removeItem(atPath: directory)
+                }
+                setenv("TMPDIR", directory, 1)
+                setenv("IAG_TRACE_FILE", "synchronous", 1)
+                // takes the same path as when the writer thread can't be started
+                setenv(asyncTraceWritesEnvironmentVariable, "0", 1)
+
+                let graph = Graph()
+                Graph.__startTracing(graph, flags: [.enabled, .full, .compact, .compressed])
+
+                let subgraph = Subgraph(graph: graph)
+                let (inputs, outputs) = subgraph.apply { WriterTests.makeAttributes() }
+                WriterTests.update(inputs, outputs, rounds: 0...WriterTests.rounds)
+
+                // every flushed buffer is already a complete frame in the file
+                let path = directory + "synchronous-0001.iag-trace"
+                guard let file = try? TraceFile(contentsOf: path), let frames = file.frames() else {
+                    Issue.record("missing or truncated trace file")
+                    return
+                }
+                #expect(frames.count > 1)
+                let writtenCount = WriterTests.beginNodeUpdateCount(file.messages()) ?? 0
+                #expect(writtenCount > 0)
+
+                Graph.__stopTracing(graph)
+
+                let stoppedFile = try? TraceFile(contentsOf: path)
+                #expect(stoppedFile?.frames() != nil)
+                #expect(
+                    WriterTests.beginNodeUpdateCount(stoppedFile?.messages())
+                        == WriterTests.attributeCount * (WriterTests.rounds + 1)
+                )
+            }
+        }
+    }
+
+}
+
+#endif
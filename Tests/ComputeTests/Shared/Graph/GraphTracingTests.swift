@@ -174,6 +174,95 @@ struct GraphTracingTests {
         #expect(context.traceCalls[1].graph == graph)
     }
 
+    #if !COMPATIBILITY_TESTS
+    class TraceEventsContext {
+        var addedAttributes: [AnyAttribute] = []
+        var dirtyAttributes: [AnyAttribute] = []
+    }
+
+    struct TestRule: Rule {
+        @Attribute var input: Int
+        var value: Int { input + 1 }
+    }
+
+    static let nodeAddedTraceEvents: UInt64 = 1 << 10
+    static let edgePendingTraceEvents: UInt64 = 1 << 12
+    static let dirtyTraceEvents: UInt64 = 1 << 13
+
+    @Test
+    func graphTraceEventsAreUnionOfConsumedEvents() {
+        var addedTrace = Graph.TraceType()
+        addedTrace.node_added = { _, _ in }
+
+        var dirtyTrace = Graph.TraceType()
+        dirtyTrace.node_set_dirty = { _, _, _ in }
+        dirtyTrace.node_set_edge_pending = { _, _, _, _ in }
+
+        let graph = Graph()
+        #expect(graph.counter(for: .traceEvents) == 0)
+
+        withUnsafeMutablePointer(to: &addedTrace) { addedTracePointer in
+            withUnsafeMutablePointer(to: &dirtyTrace) { dirtyTracePointer in
+                let addedTraceID = graph.addTrace(addedTracePointer, context: nil)
+                #expect(graph.counter(for: .traceEvents) == Self.nodeAddedTraceEvents)
+
+                let dirtyTraceID = graph.addTrace(dirtyTracePointer, context: nil)
+                #expect(
+                    graph.counter(for: .traceEvents)
+                        == Self.nodeAddedTraceEvents | Self.edgePendingTraceEvents | Self.dirtyTraceEvents
+                )
+
+                // without a trace consuming edge pending events, mark_changed takes its fast path
+                graph.removeTrace(traceID: dirtyTraceID)
+                #expect(graph.counter(for: .traceEvents) == Self.nodeAddedTraceEvents)
+
+                graph.removeTrace(traceID: addedTraceID)
+                #expect(graph.counter(for: .traceEvents) == 0)
+            }
+        }
+    }
+
+    @Test
+    func traceReceivesOnlyEventsConsumedWhenAdded() {
+        var trace = Graph.TraceType()
+        trace.node_added = { contextPointer, attribute in
+            if let context = contextPointer?.assumingMemoryBound(to: TraceEventsContext.self).pointee {
+                context.addedAttributes.append(attribute)
+            }
+        }
+
+        let graph = Graph()
+        let subgraph = Subgraph(graph: graph)
+        var context = TraceEventsContext()
+
+        withUnsafeMutablePointer(to: &trace) { tracePointer in
+            withUnsafeMutablePointer(to: &context) { contextPointer in
+                let traceID = graph.addTrace(tracePointer, context: contextPointer)
+
+                // the trace's events are read when it is added, so a callback set later is never dispatched to
+                tracePointer.pointee.node_set_dirty = { contextPointer, attribute, _ in
+                    if let context = contextPointer?.assumingMemoryBound(to: TraceEventsContext.self).pointee {
+                        context.dirtyAttributes.append(attribute)
+                    }
+                }
+
+                let (input, output) = subgraph.apply {
+                    let input = Attribute(value: 1)
+                    return (input, Attribute(TestRule(input: input)))
+                }
+                #expect(output.value == 2)
+                input.value = 2
+                #expect(output.value == 3)
+
+                graph.removeTrace(traceID: traceID)
+
+                #expect(contextPointer.pointee.addedAttributes == [input.identifier, output.identifier])
+                #expect(contextPointer.pointee.dirtyAttributes.isEmpty)
+            }
+        }
+    }
+    #endif
+
     @Test
     func namedEvents() throws {
         let eventName = Graph.traceEventName(for: Graph.NamedTraceEventID(rawValue: 0))
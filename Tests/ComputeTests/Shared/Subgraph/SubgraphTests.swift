@@ -148,6 +148,45 @@ struct SubgraphTests {
             let subgraph = try #require(subgraphOrNil)
             #expect(subgraph.isValid == false)
         }
+
+        struct TestRule: Rule {
+            @Attribute var input: Int
+            var value: Int { input + 1 }
+        }
+
+        @Test
+        func invalidateSubgraphWithEdgesIntoSurvivingSubgraph() {
+            let graph = Graph()
+            let subgraph = Subgraph(graph: graph)
+            let child = Subgraph(graph: graph)
+            subgraph.addChild(child)
+
+            let (input, survivor) = subgraph.apply {
+                let input = Attribute(value: 1)
+                return (input, Attribute(TestRule(input: input)))
+            }
+            let removed = child.apply {
+                (0..<100).map { _ in Attribute(TestRule(input: input)) }
+            }
+            let removedDependents = child.apply {
+                removed.map { Attribute(TestRule(input: $0)) }
+            }
+            #expect(survivor.value == 2)
+            #expect(removedDependents.allSatisfy { $0.value == 3 })
+
+            child.invalidate()
+
+            #expect(child.isValid == false)
+            #expect(subgraph.isValid == true)
+
+            input.value = 2
+            #expect(survivor.value == 3)
+
+            let added = subgraph.apply {
+                Attribute(TestRule(input: input))
+            }
+            #expect(added.value == 3)
+        }
     }
 
     @Suite
@@ -349,4 +388,162 @@ struct SubgraphTests {
             #expect(child.intersects(flags: Subgraph.Flags(rawValue: 1)) == true)
         }
     }
+
+    #if !COMPATIBILITY_TESTS
+    @Suite
+    struct CompactionTests {
+        struct SumRule: Rule {
+            @Attribute var count: Int
+            var inputs: [Attribute<Int>]
+            var value: Int { inputs.prefix(count).reduce(0) { $0 + $1.value } }
+        }
+
+        // Reads 300 inputs, which grows the input edges of the sum past 256 into pages of their own, then reads only 10
+        static func makeShrunkSum(subgraph: Subgraph) -> (inputs: [Attribute<Int>], sum: Attribute<Int>) {
+            let (count, inputs, sum) = subgraph.apply {
+                let count = Attribute(value: 300)
+                let inputs = (0..<300).map { _ in Attribute(value: 1) }
+                return (count, inputs, Attribute(SumRule(count: count, inputs: inputs)))
+            }
+            #expect(sum.value == 300)
+            count.value = 10
+            #expect(sum.value == 10)
+            return (inputs, sum)
+        }
+
+        @Test
+        func compactShrinksEdgeBuffers() {
+            let graph = Graph()
+            let subgraph = Subgraph(graph: graph)
+            let (inputs, sum) = CompactionTests.makeShrunkSum(subgraph: subgraph)
+
+            // 11 input edges of 8 bytes fit a capacity of 16 instead of 512
+            #expect(subgraph.compact() == (512 - 16) * 8)
+            #expect(subgraph.compact() == 0)
+
+            inputs[0].value = 2
+            #expect(sum.value == 11)
+        }
+
+        @Test
+        func compactReturnsPagesToTable() async {
+            await #expect(processExitsWith: .success) {
+                let graph = Graph()
+                let subgraph = Subgraph(graph: graph)
+                let (inputs, sum) = CompactionTests.makeShrunkSum(subgraph: subgraph)
+
+                // the 4KB buffer and its page header took 9 pages, the moved buffer may need a new one
+                let usedBytes = graph.counter(for: .dataBytes)
+                #expect(subgraph.compact() == (512 - 16) * 8)
+                #expect(usedBytes - graph.counter(for: .dataBytes) >= 8 * 512)
+
+                inputs[9].value = 2
+                #expect(sum.value == 11)
+            }
+        }
+
+        @Test
+        func compactReleasesAdjacentBufferPages() {
+            let graph = Graph()
+            let subgraph = Subgraph(graph: graph)
+
+            // each sum's buffer pages are linked next to the pages of the sums before it
+            let sums = (0..<3).map { _ in CompactionTests.makeShrunkSum(subgraph: subgraph) }
+            #expect(subgraph.compact() == 3 * (512 - 16) * 8)
+            #expect(subgraph.compact() == 0)
+
+            for (inputs, sum) in sums.reversed() {
+                inputs[0].value = 2
+                #expect(sum.value == 11)
+            }
+        }
+    }
+
+    @Suite
+    struct NodeCacheTests {
+        struct CachedRule: Rule, Hashable {
+            var seed: Int
+            var value: Int { seed * 2 }
+        }
+
+        @Test
+        func countsHitsAndMisses() {
+            let graph = Graph()
+            let subgraph = Subgraph(graph: graph)
+
+            subgraph.apply {
+                #expect(CachedRule(seed: 1).cachedValue(options: [], owner: nil) == 2)
+                #expect(CachedRule(seed: 1).cachedValue(options: [], owner: nil) == 2)
+                #expect(CachedRule(seed: 2).cachedValue(options: [], owner: nil) == 4)
+            }
+
+            #expect(graph.counter(for: .nodeCacheMisses) == 2)
+            #expect(graph.counter(for: .nodeCacheHits) == 1)
+        }
+
+        @Test
+        func evictsLeastRecentlyUsedValuesOverBudget() {
+            let graph = Graph()
+            graph.nodeCacheBudget = UInt64(MemoryLayout<Int>.size * 2)
+            let subgraph = Subgraph(graph: graph)
+
+            subgraph.apply {
+                for seed in 0..<4 {
+                    _ = CachedRule(seed: seed).cachedValue(options: [], owner: nil)
+                }
+            }
+            #expect(graph.counter(for: .nodeCacheBytes) == UInt64(MemoryLayout<Int>.size * 4))
+
+            subgraph.update(flags: [])
+            #expect(graph.counter(for: .nodeCacheEvictions) == 2)
+            #expect(graph.counter(for: .nodeCacheBytes) == UInt64(MemoryLayout<Int>.size * 2))
+
+            // the most recently used values are still cached
+            subgraph.apply {
+                #expect(CachedRule(seed: 3).cachedValue(options: [], owner: nil) == 6)
+            }
+            #expect(graph.counter(for: .nodeCacheHits) == 1)
+        }
+    }
+
+    @Suite
+    struct RecyclingTests {
+        typealias Words4 = (UInt64, UInt64, UInt64, UInt64)
+
+        // Returns the recycled allocations and bytes of adding an external attribute after freeing an edge buffer
+        func recycle<Value>(_ value: Value) -> (allocations: UInt64, bytes: UInt64) {
+            let graph = Graph()
+            let subgraph = Subgraph(graph: graph)
+
+            return subgraph.apply {
+                // growing the edges past 32 inputs frees their 256 byte buffer
+                let inputs = (0..<33).map { _ in Attribute(value: 0) }
+                let consumer = Attribute(value: 0)
+                for input in inputs {
+                    consumer.addInput(input, options: [], token: 0)
+                }
+
+                let allocations = graph.counter(for: .recycledAllocations)
+                let bytes = graph.counter(for: .recycledBytes)
+                let _ = Attribute(value: value)
+                return (
+                    graph.counter(for: .recycledAllocations) - allocations,
+                    graph.counter(for: .recycledBytes) - bytes
+                )
+            }
+        }
+
+        @Test
+        func recyclesAllocationsOfEverySizeClass() {
+            // the node of an external attribute is 28 bytes, its value is allocated separately
+            let nodeSize: UInt64 = 28
+            let words4: Words4 = (0, 0, 0, 0)
+            #expect(recycle(UInt64(0)) == (2, nodeSize + 8))
+            #expect(recycle((UInt64(0), UInt64(0), UInt64(0))) == (2, nodeSize + 24))
+            #expect(recycle((words4, UInt64(0), UInt64(0))) == (2, nodeSize + 48))
+            #expect(recycle((words4, words4, words4)) == (2, nodeSize + 96))
+            #expect(recycle((words4, words4, words4, words4)) == (2, nodeSize + 128))
+        }
+    }
+    #endif
 }
@@ -221,6 +221,70 @@ struct TreeTests {
                 keepAlivePool.removeAll()
             }
         }
+
+        @Test(.recordTree)
+        func childrenTraversingReownedAndInvalidatedChildSubgraphs() throws {
+            struct TestRule: Rule {
+                var value: String {
+                    return ""
+                }
+            }
+
+            var keepAlivePool: [Subgraph] = []
+
+            Subgraph.setShouldRecordTree()
+
+            try withGraph {
+                let attribute = Attribute(TestRule())
+                var firstOwner: Attribute<String>!
+                var secondOwner: Attribute<String>!
+                var invalidatedSubgraph: Subgraph!
+                var childAttribute: Attribute<String>!
+
+                makeTreeElement(attribute, flags: 1) {
+                    firstOwner = Attribute(TestRule())
+                    secondOwner = Attribute(TestRule())
+
+                    invalidatedSubgraph = Subgraph(graph: Subgraph.current!.graph)
+                    Subgraph.current!.addChild(invalidatedSubgraph)
+                    invalidatedSubgraph.setTreeOwner(firstOwner.identifier)
+                    invalidatedSubgraph.apply {
+                        let invalidatedAttribute = Attribute(TestRule())
+                        makeTreeElement(invalidatedAttribute, flags: 2) {
+                            // empty
+                        }
+                    }
+
+                    // Owned by the second owner first, then moved to the first
+                    let childSubgraph = Subgraph(graph: Subgraph.current!.graph)
+                    Subgraph.current!.addChild(childSubgraph)
+                    keepAlivePool.append(childSubgraph)
+                    childSubgraph.setTreeOwner(secondOwner.identifier)
+                    childSubgraph.setTreeOwner(firstOwner.identifier)
+                    childSubgraph.apply {
+                        childAttribute = Attribute(TestRule())
+                        makeTreeElement(childAttribute, flags: 3) {
+                            // empty
+                        }
+                    }
+                }
+
+                invalidatedSubgraph.invalidate()
+
+                let treeRoot = try #require(Subgraph.current?.treeRoot)
+                #expect(
+                    treeRoot.debugDescription == """
+                        (tree
+                          (element
+                            (element #:type String #:value \(attribute) #:flags 1
+                              (element #:value \(firstOwner!)
+                                (element #:type String #:value \(childAttribute!) #:flags 3)))))
+                        """
+                )
+
+                keepAlivePool.removeAll()
+            }
+        }
     }
 
     @Test
@@ -0,0 +1,209 @@
+import Foundation
+
+/// Decodes trace files written by the graph's trace recorder.
+public struct TraceFile {
+
+    public static let compressedFileMagic = Array("IAGTRCZ1".utf8)
+
+    public struct Frame {
+        public var size: Int
+        public var storedSize: Int
+        public var bytes: [UInt8]
+
+        public var isCompressed: Bool { storedSize != size }
+    }
+
+    public struct Field {
+        public var number: UInt64
+        public var value: UInt64  // varint fields only
+        public var bytes: ArraySlice<UInt8>  // length delimited fields only
+    }
+
+    public struct Event {
+        public var type: UInt64
+        public var fields: [Field]
+
+        public func field(_ number: UInt64) -> Field? {
+            fields.first { $0.number == number }
+        }
+    }
+
+    public var bytes: [UInt8]
+
+    public init(contentsOf path: String) throws {
+        bytes = Array(try Data(contentsOf: URL(fileURLWithPath: path)))
+    }
+
+    public var isCompressed: Bool {
+        bytes.starts(with: Self.compressedFileMagic)
+    }
+
+    /// Splits a compressed file into frames, each decompressed to the size recorded in its header.
+    public func frames() -> [Frame]? {
+        guard isCompressed else {
+            return nil
+        }
+        var frames: [Frame] = []
+        var position = Self.compressedFileMagic.count
+        while position < bytes.count {
+            guard position + 8 <= bytes.count else {
+                return nil
+            }
+            let size = Int(readUInt32(at: position))
+            let storedSize = Int(readUInt32(at: position + 4))
+            position += 8
+            guard position + storedSize <= bytes.count else {
+                return nil
+            }
+            let stored = bytes[position..<(position + storedSize)]
+            position += storedSize
+
+            if storedSize == size {
+                frames.append(Frame(size: size, storedSize: storedSize, bytes: Array(stored)))
+            } else {
+                guard let decompressed = Self.decompress(stored), decompressed.count == size else {
+                    return nil
+                }
+                frames.append(Frame(size: size, storedSize: storedSize, bytes: decompressed))
+            }
+        }
+        return frames
+    }
+
+    /// The encoded messages of the trace, with any compression removed.
+    public func messages() -> [UInt8]? {
+        guard isCompressed else {
+            return bytes
+        }
+        return frames()?.flatMap(\.bytes)
+    }
+
+    private func readUInt32(at position: Int) -> UInt32 {
+        (0..<4).reduce(0) { $0 | UInt32(bytes[position + $1]) << ($1 * 8) }
+    }
+
+    // MARK: Block compression
+
+    /// Decompresses a block in the format of util::block_compression.
+    public static func decompress(_ block: ArraySlice<UInt8>) -> [UInt8]? {
+        var output: [UInt8] = []
+        var input = block.startIndex
+
+        func readLength(_ length: inout Int) -> Bool {
+            guard length == 15 else {
+                return true
+            }
+            while input < block.endIndex {
+                let byte = block[input]
+                input += 1
+                length += Int(byte)
+                if byte != 255 {
+                    return true
+                }
+            }
+            return false
+        }
+
+        while input < block.endIndex {
+            let token = block[input]
+            input += 1
+
+            var literalLength = Int(token >> 4)
+            guard readLength(&literalLength), block.endIndex - input >= literalLength else {
+                return nil
+            }
+            output.append(contentsOf: block[input..<(input + literalLength)])
+            input += literalLength
+
+            if input == block.endIndex {
+                break
+            }
+
+            guard block.endIndex - input >= 2 else {
+                return nil
+            }
+            let offset = Int(block[input]) | Int(block[input + 1]) << 8
+            input += 2
+            guard offset > 0 && offset <= output.count else {
+                return nil
+            }
+
+            var matchLength = Int(token & 0xf)
+            guard readLength(&matchLength) else {
+                return nil
+            }
+            matchLength += 4
+            for _ in 0..<matchLength {
+                output.append(output[output.count - offset])
+            }
+        }
+        return output
+    }
+
+    // MARK: Messages
+
+    /// Parses the fields of a message, returning nil if it is malformed.
+    public static func fields(_ message: ArraySlice<UInt8>) -> [Field]? {
+        var fields: [Field] = []
+        var position = message.startIndex
+
+        func readVarint() -> UInt64? {
+            var value: UInt64 = 0
+            var shift: UInt64 = 0
+            while position < message.endIndex && shift < 64 {
+                let byte = message[position]
+                position += 1
+                value |= UInt64(byte & 0x7f) << shift
+                if byte & 0x80 == 0 {
+                    return value
+                }
+                shift += 7
+            }
+            return nil
+        }
+
+        while position < message.endIndex {
+            guard let tag = readVarint() else {
+                return nil
+            }
+            let number = tag >> 3
+            switch tag & 0x7 {
+            case 0:
+                guard let value = readVarint() else {
+                    return nil
+                }
+                fields.append(Field(number: number, value: value, bytes: []))
+            case 1:
+                guard message.endIndex - position >= 8 else {
+                    return nil
+                }
+                let value = (0..<8).reduce(UInt64(0)) { $0 | UInt64(message[position + $1]) << ($1 * 8) }
+                position += 8
+                fields.append(Field(number: number, value: value, bytes: []))
+            case 2:
+                guard let length = readVarint(), UInt64(message.endIndex - position) >= length else {
+                    return nil
+                }
+                let bytes = message[position..<(position + Int(length))]
+                position += Int(length)
+                fields.append(Field(number: number, value: 0, bytes: bytes))
+            default:
+                return nil
+            }
+        }
+        return fields
+    }
+
+    /// The events of a compact trace, which are top-level fields numbered 64 plus their event type.
+    public static func compactEvents(_ fields: [Field]) -> [Event]? {
+        var events: [Event] = []
+        for field in fields where field.number >= 64 {
+            guard let eventFields = Self.fields(field.bytes) else {
+                return nil
+            }
+            events.append(Event(type: field.number - 64, fields: eventFields))
+        }
+        return events
+    }
+
+}
@@ -41,5 +41,55 @@ struct TracingComparisonTests {
             try #require(compareFailedEntries.count == 1)
             #expect(compareFailedEntries[0].attribute == attribute.identifier)
         }
+
+        #if !COMPATIBILITY_TESTS
+        // 127 bytes cover every lane of the 32 and 16 byte vector loops, the 8 byte word loop and the byte tail
+        typealias Bytes127 = (SIMD64<UInt8>, SIMD32<UInt8>, SIMD16<UInt8>, SIMD8<UInt8>, UInt32, UInt16, UInt8)
+
+        struct FlippedByteRule: Rule {
+            @Attribute var index: Int
+            var value: Bytes127 {
+                var bytes: Bytes127 = (.zero, .zero, .zero, .zero, 0, 0, 0)
+                if index >= 0 {
+                    withUnsafeMutableBytes(of: &bytes) { $0[index] = 1 }
+                }
+                return bytes
+            }
+        }
+
+        @Test
+        func traceCompareFailedReportsFirstDifferingByte() throws {
+            class FailureLocationTrace: TestTraceRecorder {
+                var locations: [Int] = []
+
+                override func compareFailed(attribute: AnyAttribute, comparisonState: ComparisonState) {
+                    super.compareFailed(attribute: attribute, comparisonState: comparisonState)
+                    locations.append(__IAGComparisonStateGetFieldRange(comparisonState).offset)
+                }
+            }
+
+            let graph = Graph()
+            let recorder = FailureLocationTrace()
+            recorder.install(graph: graph)
+
+            let subgraph = Subgraph(graph: graph)
+            let (index, attribute) = subgraph.apply {
+                let index = Attribute(value: -1)
+                return (index, Attribute(FlippedByteRule(index: index)))
+            }
+            _ = attribute.value
+
+            // set and clear each byte in turn, both changes first differ at that byte
+            let size = MemoryLayout<Bytes127>.size
+            for location in 0..<size {
+                index.value = location
+                _ = attribute.value
+                index.value = -1
+                _ = attribute.value
+            }
+
+            #expect(recorder.locations == (0..<size).flatMap { [$0, $0] })
+        }
+        #endif
     }
 }
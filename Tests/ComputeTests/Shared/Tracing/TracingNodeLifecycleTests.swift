@@ -631,6 +631,51 @@ struct TracingNodeLifecycleTests {
             #expect(nodeSetValueEntries[0].attribute == attribute.identifier)
             #expect(recorder.capturedValue == 42)
         }
+
+        #if !COMPATIBILITY_TESTS
+        struct SumRule: Rule {
+            @Attribute var first: Int
+            @Attribute var second: Int
+            var value: Int { first + second }
+        }
+
+        @Test
+        func traceNodeSetValueCalledOnSetValues() throws {
+            let graph = Graph()
+            let recorder = TestTraceRecorder()
+            recorder.install(graph: graph)
+
+            let subgraph = Subgraph(graph: graph)
+            let (first, second, output) = subgraph.apply {
+                let first = Attribute(value: 1)
+                let second = Attribute(value: 2)
+                return (first, second, Attribute(SumRule(first: first, second: second)))
+            }
+            #expect(output.value == 3)
+
+            try #require(recorder.history.nodeSetValueEntries.count == 2)
+
+            let changedCount = Graph.setValues([first, second], to: [10, 2])
+            #expect(changedCount == 1)
+
+            let nodeSetValueEntries = recorder.history.nodeSetValueEntries
+            try #require(nodeSetValueEntries.count == 4)
+            #expect(nodeSetValueEntries[2].attribute == first.identifier)
+            #expect(nodeSetValueEntries[3].attribute == second.identifier)
+
+            let outputSetDirtyEntries = recorder.history.nodeSetDirtyEntries.filter {
+                $0.attribute == output.identifier
+            }
+            #expect(outputSetDirtyEntries.count == 1)
+            #expect(output.value == 12)
+
+            let beginEventEntries = recorder.history.beginEventEntries
+            try #require(beginEventEntries.count == 1)
+            #expect(beginEventEntries[0].attribute == first.identifier)
+            #expect(beginEventEntries[0].eventName == "set_values")
+            #expect(recorder.history.endEventEntries.map(\.eventName) == ["set_values"])
+        }
+        #endif
     }
 
     @Suite
@@ -654,6 +699,50 @@ struct TracingNodeLifecycleTests {
             try #require(nodeMarkValueEntries.count == 1)
             #expect(nodeMarkValueEntries[0].attribute == attribute.identifier)
         }
+
+        #if !COMPATIBILITY_TESTS
+        struct SumRule: Rule {
+            @Attribute var first: Int
+            @Attribute var second: Int
+            var value: Int { first + second }
+        }
+
+        @Test
+        func traceNodeMarkValueCalledOnInvalidateValues() throws {
+            let graph = Graph()
+            let recorder = TestTraceRecorder()
+            recorder.install(graph: graph)
+
+            let subgraph = Subgraph(graph: graph)
+            let (first, second, output) = subgraph.apply {
+                let first = Attribute(value: 1)
+                let second = Attribute(value: 2)
+                return (first, second, Attribute(SumRule(first: first, second: second)))
+            }
+            #expect(output.value == 3)
+
+            try #require(recorder.history.nodeMarkValueEntries.count == 0)
+
+            Graph.invalidateValues([first.identifier, second.identifier])
+
+            let nodeMarkValueEntries = recorder.history.nodeMarkValueEntries
+            try #require(nodeMarkValueEntries.count == 2)
+            #expect(nodeMarkValueEntries[0].attribute == first.identifier)
+            #expect(nodeMarkValueEntries[1].attribute == second.identifier)
+
+            let outputSetDirtyEntries = recorder.history.nodeSetDirtyEntries.filter {
+                $0.attribute == output.identifier
+            }
+            #expect(outputSetDirtyEntries.count == 1)
+            #expect(output.value == 3)
+
+            let beginEventEntries = recorder.history.beginEventEntries
+            try #require(beginEventEntries.count == 1)
+            #expect(beginEventEntries[0].attribute == first.identifier)
+            #expect(beginEventEntries[0].eventName == "invalidate_values")
+            #expect(recorder.history.endEventEntries.map(\.eventName) == ["invalidate_values"])
+        }
+        #endif
     }
 
     @Suite
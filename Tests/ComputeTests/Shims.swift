@@ -3,6 +3,8 @@
 let prefetchLayoutsEnvironmentVariable = "IAG_PREFETCH_LAYOUTS"
 let asyncLayoutsEnvironmentVariable = "IAG_ASYNC_LAYOUTS"
 let printLayoutsEnvironmentVariable = "IAG_PRINT_LAYOUTS"
+let asyncTraceWritesEnvironmentVariable = "IAG_ASYNC_TRACE_WRITES"
+let reserveDataSpaceEnvironmentVariable = "IAG_RESERVE_DATA_SPACE"
 
 extension Graph: @retroactive Equatable {
     public static func == (_ lhs: Graph, _ rhs: Graph) -> Bool {
@@ -0,0 +1,63 @@
+import Testing
+import Utilities
+
+@Suite("BlockCompression tests")
+struct BlockCompressionTests {
+
+    func roundTrip(_ bytes: [UInt8]) -> (compressedSize: Int, decompressed: [UInt8]) {
+        let capacity = util.block_compression.compress_bound(bytes.count)
+        var compressed = [UInt8](repeating: 0, count: capacity)
+        let compressedSize = bytes.withUnsafeBytes { source in
+            compressed.withUnsafeMutableBytes { destination in
+                util.block_compression.compress(source.baseAddress!, source.count, destination.baseAddress!, capacity)
+            }
+        }
+        #expect(compressedSize != util.block_compression.failed)
+
+        var decompressed = [UInt8](repeating: 0, count: bytes.count + 1)
+        let decompressedSize = compressed.withUnsafeBytes { source in
+            decompressed.withUnsafeMutableBytes { destination in
+                util.block_compression.decompress(
+                    source.baseAddress!,
+                    compressedSize,
+                    destination.baseAddress!,
+                    destination.count
+                )
+            }
+        }
+        #expect(decompressedSize != util.block_compression.failed)
+
+        return (compressedSize, Array(decompressed.prefix(decompressedSize)))
+    }
+
+    @Test("Repetitive input compresses and round trips")
+    func repetitiveInput() {
+        let bytes = (0..<10_000).flatMap { i -> [UInt8] in [0x0a, 0x06, 0x08, UInt8(40 + i % 3), 0x58, 0x02] }
+        let (compressedSize, decompressed) = roundTrip(bytes)
+        #expect(decompressed == bytes)
+        #expect(compressedSize < bytes.count / 4)
+    }
+
+    @Test("Incompressible input round trips")
+    func randomInput() {
+        var generator = SystemRandomNumberGenerator()
+        let bytes = (0..<5_000).map { _ in UInt8.random(in: 0...255, using: &generator) }
+        let (compressedSize, decompressed) = roundTrip(bytes)
+        #expect(decompressed == bytes)
+        #expect(compressedSize <= util.block_compression.compress_bound(bytes.count))
+    }
+
+    @Test("Matches that reference past the start of the output are rejected")
+    func malformedInput() {
+        // token with one literal and a four byte match, followed by an offset of two
+        let block: [UInt8] = [0x10, 0x41, 0x02, 0x00]
+        var output = [UInt8](repeating: 0, count: 16)
+        let result = block.withUnsafeBytes { source in
+            output.withUnsafeMutableBytes { destination in
+                util.block_compression.decompress(source.baseAddress!, source.count, destination.baseAddress!, 16)
+            }
+        }
+        #expect(result == util.block_compression.failed)
+    }
+
+}
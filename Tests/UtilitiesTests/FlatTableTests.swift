@@ -0,0 +1,151 @@
+import Foundation
+import Testing
+import Utilities
+
+@Suite("FlatTable tests")
+struct FlatTableTests {
+
+    @Test("Initialize empty table")
+    func initEmpty() {
+        let table = util.UntypedFlatTable.create()
+        defer {
+            util.UntypedFlatTable.destroy(table)
+        }
+
+        #expect(table.empty())
+        #expect(table.count() == 0)
+    }
+
+    @Test("Insert, replace and remove entries")
+    func insertReplaceRemove() {
+        let table = util.UntypedFlatTable.create()
+        defer {
+            util.UntypedFlatTable.destroy(table)
+        }
+
+        var key = 1
+        var value1 = 100
+        var value2 = 200
+        withUnsafePointer(to: &key) { keyPointer in
+            withUnsafePointer(to: &value1) { v1 in
+                #expect(table.insert(keyPointer, v1) == true)
+            }
+            withUnsafePointer(to: &value2) { v2 in
+                #expect(table.insert(keyPointer, v2) == false, "Inserting an existing key replaces its value")
+            }
+            #expect(table.count() == 1)
+
+            let found = table.__lookupUnsafe(keyPointer, nil)
+            #expect(found?.assumingMemoryBound(to: Int.self).pointee == 200)
+
+            #expect(table.remove(keyPointer) == true)
+            #expect(table.remove(keyPointer) == false)
+            #expect(table.count() == 0)
+            #expect(table.__lookupUnsafe(keyPointer, nil) == nil)
+        }
+    }
+
+    @Test("Growing and removing keeps all other entries reachable")
+    func growAndRemove() {
+        let table = util.UntypedFlatTable.create()
+        defer {
+            util.UntypedFlatTable.destroy(table)
+        }
+
+        let itemCount = 1000
+        let keys = UnsafeMutablePointer<Int>.allocate(capacity: itemCount)
+        defer {
+            keys.deallocate()
+        }
+
+        for i in 0..<itemCount {
+            #expect(table.insert(keys + i, keys + i) == true, "Insert \(i) should succeed")
+        }
+        #expect(table.count() == UInt64(itemCount))
+
+        // Remove every other key, leaving deleted slots between the remaining entries
+        for i in stride(from: 0, to: itemCount, by: 2) {
+            #expect(table.remove(keys + i) == true)
+        }
+        #expect(table.count() == UInt64(itemCount / 2))
+
+        for i in 0..<itemCount {
+            let found = table.__lookupUnsafe(keys + i, nil)
+            if i % 2 == 0 {
+                #expect(found == nil, "Key \(i) should have been removed")
+            } else {
+                #expect(found == UnsafeRawPointer(keys + i), "Key \(i) should be found")
+            }
+        }
+
+        // Reinsert, reusing deleted slots
+        for i in stride(from: 0, to: itemCount, by: 2) {
+            #expect(table.insert(keys + i, keys + i) == true)
+        }
+
+        var iterationCount = 0
+        table.for_each(
+            { _, _, context in
+                let countPtr = context.assumingMemoryBound(to: Int.self)
+                countPtr.pointee += 1
+            },
+            &iterationCount
+        )
+        #expect(iterationCount == itemCount, "for_each should visit all \(itemCount) items")
+    }
+
+    @Test("Benchmark lookups against UntypedTable")
+    func benchmarkLookup() {
+        let itemCount = 10_000
+        let iterations = 100
+        let keys = UnsafeMutablePointer<Int>.allocate(capacity: itemCount)
+        defer {
+            keys.deallocate()
+        }
+
+        let chainedTable = util.UntypedTable.create()
+        let flatTable = util.UntypedFlatTable.create()
+        defer {
+            util.UntypedTable.destroy(chainedTable)
+            util.UntypedFlatTable.destroy(flatTable)
+        }
+
+        let clock = ContinuousClock()
+        let chainedInsertDuration = clock.measure {
+            for i in 0..<itemCount {
+                _ = chainedTable.insert(keys + i, keys + i)
+            }
+        }
+        let flatInsertDuration = clock.measure {
+            for i in 0..<itemCount {
+                _ = flatTable.insert(keys + i, keys + i)
+            }
+        }
+
+        var chainedFound = 0
+        let chainedLookupDuration = clock.measure {
+            for _ in 0..<iterations {
+                for i in 0..<itemCount where chainedTable.__lookupUnsafe(keys + i, nil) != nil {
+                    chainedFound += 1
+                }
+            }
+        }
+        var flatFound = 0
+        let flatLookupDuration = clock.measure {
+            for _ in 0..<iterations {
+                for i in 0..<itemCount where flatTable.__lookupUnsafe(keys + i, nil) != nil {
+                    flatFound += 1
+                }
+            }
+        }
+
+        #expect(chainedFound == itemCount * iterations)
+        #expect(flatFound == itemCount * iterations)
+
+        print("UntypedTable insert: \(chainedInsertDuration / itemCount) per entry")
+        print("UntypedFlatTable insert: \(flatInsertDuration / itemCount) per entry")
+        print("UntypedTable lookup: \(chainedLookupDuration / (itemCount * iterations)) per lookup")
+        print("UntypedFlatTable lookup: \(flatLookupDuration / (itemCount * iterations)) per lookup")
+    }
+
+}